@@ -0,0 +1,13 @@
+#version 330
+
+in vec2 vUv;
+in vec4 vColor;
+
+// Single channel glyph atlas, red holds the glyph coverage
+uniform sampler2D uAtlas;
+
+out vec4 color;
+
+void main() {
+    color = vec4(vColor.rgb, vColor.a * texture(uAtlas, vUv).r);
+}
\ No newline at end of file
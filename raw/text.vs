@@ -0,0 +1,17 @@
+#version 330
+
+in vec2 aPos;
+in vec2 aUv;
+in vec4 aColor;
+
+// Pixel coordinates, origin at the top-left corner of the screen
+uniform mat4 uProjection;
+
+out vec2 vUv;
+out vec4 vColor;
+
+void main() {
+    gl_Position = uProjection * vec4(aPos, 0.0, 1.0);
+    vUv = aUv;
+    vColor = aColor;
+}
\ No newline at end of file
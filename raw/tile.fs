@@ -1,10 +1,60 @@
 #version 330
 
+// Permutations are selected by TileShader via #defines injected after #version:
+//  TEXTURED  - sample uTexture, otherwise the tile is a flat uColor quad
+//  TINT_HSV  - recolor the texture with the hue of uColor (uColorHsv is precomputed on the CPU)
+//  (none)    - textured tiles are modulated by uColor
+//  SDF       - no texture, the tile shape (TileShape) is evaluated analytically, so it
+//              stays sharp at any tile size. Drawn in the plain tile color.
+//  INSTANCED - the color (and its HSV, and the shape) comes from the instance instead of uniforms
+//  ANIMATED  - INSTANCED, with the color (and its HSV) animated in tile.vs
+
 in vec2 vUv;
 
+#ifdef INSTANCED
+in vec4 vColor;
+flat in vec3 vColorHsv;
+flat in int vShape;
+#define TILE_COLOR vColor
+#define TILE_COLOR_HSV vColorHsv
+#define TILE_SHAPE vShape
+#else
 uniform vec4 uColor;
-uniform int uTextureEnabled;
+uniform int uShape;
+#define TILE_COLOR uColor
+#define TILE_COLOR_HSV uColorHsv
+#define TILE_SHAPE uShape
+#endif
+
+#ifdef SDF
+// Proportions of the Base/Circle/Cross sprites, in uv units
+const float FrameHalfSize = 0.4365;
+const float FrameRadius = 0.055;
+const float MarkSize = 0.25;
+const float LineHalfWidth = 0.0117;
+const float GlowWidth = 0.0137;
+
+float sdRoundBox(vec2 p, vec2 halfSize, float radius) {
+    vec2 q = abs(p) - halfSize + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+float sdSegment(vec2 p, vec2 a, vec2 b) {
+    vec2 pa = p - a;
+    vec2 ba = b - a;
+    float h = clamp(dot(pa, ba) / dot(ba, ba), 0.0, 1.0);
+    return length(pa - ba * h);
+}
+#endif
+
+#ifdef TEXTURED
 uniform sampler2D uTexture;
+#endif
+
+#if defined(TEXTURED) && defined(TINT_HSV)
+#ifndef INSTANCED
+uniform vec3 uColorHsv;
+#endif
 
 vec3 rgb2hsv(vec3 c)
 {
@@ -23,16 +73,34 @@ vec3 hsv2rgb(vec3 c)
     vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);
     return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);
 }
+#endif
 
 out vec4 color;
 
 void main() {
-    vec3 color_hsv = rgb2hsv(uColor.xyz);
-
-    color = uColor;
-    if (uTextureEnabled != 0) {
-        vec4 tex_color = texture(uTexture, vUv);
-        vec3 tex_hsv = rgb2hsv(tex_color.xyz);
-        color = vec4(hsv2rgb(vec3(color_hsv.r, tex_hsv.g * color_hsv.g, tex_hsv.b * color_hsv.b)), uColor.a * tex_color.a);
+#if defined(SDF)
+    // Distance to the nearest stroke centerline: the frame, plus the mark of the shape
+    vec2 p = vUv - 0.5;
+    float d = abs(sdRoundBox(p, vec2(FrameHalfSize), FrameRadius));
+    if (TILE_SHAPE == 2) {
+        d = min(d, abs(length(p) - MarkSize));
+    } else if (TILE_SHAPE == 3) {
+        d = min(d, sdSegment(p, vec2(-MarkSize), vec2(MarkSize)));
+        d = min(d, sdSegment(p, vec2(-MarkSize, MarkSize), vec2(MarkSize, -MarkSize)));
     }
+    d -= LineHalfWidth;
+
+    float aa = fwidth(d);
+    color = vec4(TILE_COLOR.rgb, TILE_COLOR.a * (1.0 - smoothstep(-aa, GlowWidth + aa, d)));
+#elif defined(TEXTURED)
+    vec4 tex_color = texture(uTexture, vUv);
+#if defined(TINT_HSV)
+    vec3 tex_hsv = rgb2hsv(tex_color.xyz);
+    color = vec4(hsv2rgb(vec3(TILE_COLOR_HSV.r, tex_hsv.g * TILE_COLOR_HSV.g, tex_hsv.b * TILE_COLOR_HSV.b)), TILE_COLOR.a * tex_color.a);
+#else
+    color = TILE_COLOR * tex_color;
+#endif
+#else
+    color = TILE_COLOR;
+#endif
 }
\ No newline at end of file
@@ -3,11 +3,91 @@
 in vec3 aPos;
 in vec2 aUv;
 
+// Without INSTANCED uMvp places the single tile, with it uMvp is the view-projection and
+// every instance carries its own placement and color
 uniform mat4 uMvp;
 
+#ifdef INSTANCED
+in vec4 aRect;      // center xy, size zw
+in vec4 aColor;
+in vec4 aColorHsv;  // HSV of aColor, depth in w
+in float aShape;
+
+out vec4 vColor;
+flat out vec3 vColorHsv;
+flat out int vShape;
+#endif
+
+#ifdef ANIMATED
+// Two animation tracks per instance (one-shot events, then loops), each a start time,
+// duration, AnimationCurve and target scale, plus the target color
+in vec4 aEvent;
+in vec4 aEventColor;
+in vec4 aLoop;
+in vec4 aLoopColor;
+
+uniform float uTime;
+
+const float Pi = 3.14159265;
+const float BackOvershoot = 1.70158;
+
+// How far the tile is pulled towards the animation target at uTime, 0 is the plain tile.
+// One-shot curves start on the target and settle on the tile, Pulse loops between both.
+float animationWeight(vec4 animation) {
+    int curve = int(animation.z);
+    float elapsed = uTime - animation.x;
+    if (curve == 3) {
+        return elapsed < 0.0 ? 0.0 : abs(sin(Pi * elapsed / animation.y));
+    }
+
+    float t = clamp(elapsed / animation.y, 0.0, 1.0) - 1.0;
+    if (curve == 1) {
+        return -t * t * t;
+    } else if (curve == 2) {
+        // 1 - easeOutBack, dips below 0 before settling: the tile overshoots its size
+        return -t * t * ((BackOvershoot + 1.0) * t + BackOvershoot);
+    }
+    return 0.0;
+}
+
+#if defined(TEXTURED) && defined(TINT_HSV)
+// Same as tile.fs. The animated color is the same for every vertex of an instance, so its
+// HSV is computed once per vertex here instead of once per fragment.
+vec3 rgb2hsv(vec3 c)
+{
+    vec4 K = vec4(0.0, -1.0 / 3.0, 2.0 / 3.0, -1.0);
+    vec4 p = mix(vec4(c.bg, K.wz), vec4(c.gb, K.xy), step(c.b, c.g));
+    vec4 q = mix(vec4(p.xyw, c.r), vec4(c.r, p.yzx), step(p.x, c.r));
+
+    float d = q.x - min(q.w, q.y);
+    float e = 1.0e-10;
+    return vec3(abs(q.z + (q.w - q.y) / (6.0 * d + e)), d / (q.x + e), q.x);
+}
+#endif
+#endif
+
 out vec2 vUv;
 
 void main() {
+#if defined(ANIMATED)
+    float event = animationWeight(aEvent);
+    float loop = animationWeight(aLoop);
+    vec2 scale = aRect.zw * mix(1.0, aEvent.w, event) * mix(1.0, aLoop.w, loop);
+    gl_Position = uMvp * vec4(aPos.xy * scale + aRect.xy, aPos.z + aColorHsv.w, 1.0);
+    vColor = clamp(mix(mix(aColor, aEventColor, event), aLoopColor, loop), 0.0, 1.0);
+#if defined(TEXTURED) && defined(TINT_HSV)
+    vColorHsv = rgb2hsv(vColor.rgb);
+#else
+    vColorHsv = aColorHsv.xyz;
+#endif
+    vShape = int(aShape);
+#elif defined(INSTANCED)
+    gl_Position = uMvp * vec4(aPos.xy * aRect.zw + aRect.xy, aPos.z + aColorHsv.w, 1.0);
+    vColor = aColor;
+    vColorHsv = aColorHsv.xyz;
+    vShape = int(aShape);
+#else
     gl_Position = uMvp * vec4(aPos, 1.0);
+#endif
     vUv = aUv;
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "frame_scheduler.hpp"
+#include "trace.hpp"
+#include <thread>
+
+namespace core {
+	FrameScheduler::FrameScheduler(double fixedStep, unsigned int maxStepsPerFrame) :
+		fixedStep(fixedStep), maxStepsPerFrame(maxStepsPerFrame), pacing(FramePacing::Vsync60), targetFrameTime(0.0),
+		lastFrame(Clock::now()), frameStart(lastFrame), accumulator(0.0), simulationTime(0.0), frameDelta(0.0), frameIndex(0) {
+
+	}
+
+	void FrameScheduler::SetPacing(FramePacing pacing) {
+		this->pacing = pacing;
+	}
+
+	int FrameScheduler::SwapInterval() const {
+		switch (pacing) {
+			case FramePacing::Vsync60:
+				return 1;
+			case FramePacing::Vsync30:
+				return 2;
+			case FramePacing::Unlocked:
+				return 0;
+		}
+		return 1;
+	}
+
+	void FrameScheduler::SetTargetFrameRate(double fps) {
+		targetFrameTime = fps > 0.0 ? 1.0 / fps : 0.0;
+	}
+
+	unsigned int FrameScheduler::BeginFrame() {
+		frameStart = Clock::now();
+		frameDelta = std::chrono::duration<double>(frameStart - lastFrame).count();
+		lastFrame = frameStart;
+		frameIndex++;
+
+		accumulator += frameDelta;
+
+		unsigned int steps = 0;
+		while (accumulator >= fixedStep && steps < maxStepsPerFrame) {
+			accumulator -= fixedStep;
+			simulationTime += fixedStep;
+			steps++;
+		}
+
+		// After a long stall (breakpoint, suspended applet) drop the backlog instead of
+		// spiraling into ever longer frames
+		if (steps == maxStepsPerFrame && accumulator >= fixedStep) {
+			accumulator = 0.0;
+		}
+
+		TRACE_COUNTER("SimulationSteps", steps);
+		return steps;
+	}
+
+	void FrameScheduler::EndFrame() {
+		if (targetFrameTime <= 0.0) {
+			return;
+		}
+
+		TRACE_ZONE("FrameScheduler::Wait");
+		auto target = frameStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(targetFrameTime));
+		if (Clock::now() < target) {
+			std::this_thread::sleep_until(target);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <chrono>
+
+namespace core {
+	enum class FramePacing {
+		Vsync60,	// Present every vblank
+		Vsync30,	// Present every other vblank, halves CPU/GPU use in low-power sessions
+		Unlocked	// No vsync, optionally capped by the target frame rate
+	};
+
+	// Decouples the simulation from rendering: the simulation advances in fixed steps driven
+	// by a monotonic clock, rendering runs once per frame and interpolates between the last
+	// two simulation states with Alpha().
+	//
+	// Per frame:
+	//   unsigned int steps = scheduler.BeginFrame();
+	//   for (unsigned int i = 0; i < steps; i++) Update(scheduler.FixedStep());
+	//   Render(scheduler.Alpha());
+	//   Present();
+	//   scheduler.EndFrame();
+	class FrameScheduler {
+	public:
+		typedef std::chrono::steady_clock Clock;
+	protected:
+		double fixedStep;
+		unsigned int maxStepsPerFrame;
+		FramePacing pacing;
+		double targetFrameTime;
+
+		Clock::time_point lastFrame;
+		Clock::time_point frameStart;
+		double accumulator;
+		double simulationTime;
+		double frameDelta;
+		unsigned long long frameIndex;
+	public:
+		FrameScheduler(double fixedStep = 1.0 / 60.0, unsigned int maxStepsPerFrame = 8);
+
+		void SetPacing(FramePacing pacing);
+		inline FramePacing Pacing() const { return pacing; }
+
+		// eglSwapInterval value matching the current pacing
+		int SwapInterval() const;
+
+		// Caps the frame rate by sleeping in EndFrame(), 0 disables the cap
+		void SetTargetFrameRate(double fps);
+
+		// Starts a new frame and returns how many fixed simulation steps must run in it
+		unsigned int BeginFrame();
+		void EndFrame();
+
+		inline double FixedStep() const { return fixedStep; }
+		// Simulation time after all the steps returned by BeginFrame() have run
+		inline double SimulationTime() const { return simulationTime; }
+		// Wall-clock duration of the last frame
+		inline double FrameDelta() const { return frameDelta; }
+		inline unsigned long long FrameIndex() const { return frameIndex; }
+
+		// Interpolation factor between the previous and current simulation state, in [0, 1)
+		inline float Alpha() const { return static_cast<float>(accumulator / fixedStep); }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "input.hpp"
+#include "log.hpp"
+#include "trace.hpp"
+#include <thread>
+
+namespace core {
+	namespace {
+		constexpr size_t PollerStackSize = 64 * 1024;
+		constexpr int PollerCore = 2;
+	}
+
+	InputPoller::InputPoller(std::chrono::microseconds interval) : pad(), running(false), interval(interval), dropped(0) {
+
+	}
+
+	bool InputPoller::Start() {
+		if (running.load()) {
+			return false;
+		}
+
+		padInitializeDefault(&pad);
+
+		// Lower values are higher priorities
+		s32 priority = 0x2C;
+		svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+		running.store(true);
+		Result rc = threadCreate(&thread, &InputPoller::ThreadEntry, this, nullptr, PollerStackSize, priority - 1, PollerCore);
+		if (R_SUCCEEDED(rc)) {
+			rc = threadStart(&thread);
+			if (R_FAILED(rc)) {
+				threadClose(&thread);
+			}
+		}
+		if (R_FAILED(rc)) {
+			LOG_ERROR("INPUT", "Failed to start the polling thread: 0x%x", rc);
+			running.store(false);
+			return false;
+		}
+		LOG_INFO("INPUT", "Polling every %lld us", static_cast<long long>(interval.count()));
+		return true;
+	}
+
+	void InputPoller::Stop() {
+		if (!running.exchange(false)) {
+			return;
+		}
+
+		threadWaitForExit(&thread);
+		threadClose(&thread);
+
+		uint64_t lost = DroppedCount();
+		if (lost > 0) {
+			LOG_WARN("INPUT", "%llu input events dropped", static_cast<unsigned long long>(lost));
+		}
+	}
+
+	void InputPoller::Push(uint64_t buttons, InputEventType type, InputClock::time_point now) {
+		InputEvent event;
+		event.buttons = buttons;
+		event.type = type;
+		event.timestamp = now;
+		if (!events.Push(event)) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void InputPoller::ThreadEntry(void* poller) {
+		static_cast<InputPoller*>(poller)->Run();
+	}
+
+	void InputPoller::Run() {
+		TRACE_THREAD_NAME("Input");
+
+		InputClock::time_point next = InputClock::now();
+		while (running.load(std::memory_order_relaxed)) {
+			padUpdate(&pad);
+			InputClock::time_point now = InputClock::now();
+
+			uint64_t down = padGetButtonsDown(&pad);
+			uint64_t up = padGetButtonsUp(&pad);
+			if (down != 0) {
+				Push(down, InputEventType::Down, now);
+			}
+			if (up != 0) {
+				Push(up, InputEventType::Up, now);
+			}
+
+			// Fixed rate, but never try to catch up on ticks missed while preempted
+			next += interval;
+			if (next < now) {
+				next = now;
+			}
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+	InputPoller::~InputPoller() {
+		Stop();
+	}
+
+	InputLatency::InputLatency() : hasPending(false), samples(0), totalMs(0.0), maxMs(0.0), lastMs(0.0) {
+
+	}
+
+	void InputLatency::Handled(const InputEvent& event) {
+		if (!hasPending || event.timestamp < pending) {
+			pending = event.timestamp;
+			hasPending = true;
+		}
+	}
+
+	void InputLatency::Presented(InputClock::time_point now) {
+		if (!hasPending) {
+			return;
+		}
+
+		lastMs = std::chrono::duration<double, std::milli>(now - pending).count();
+		hasPending = false;
+		samples++;
+		totalMs += lastMs;
+		if (lastMs > maxMs) {
+			maxMs = lastMs;
+		}
+
+		TRACE_COUNTER("Input latency (us)", static_cast<int64_t>(lastMs * 1000.0));
+	}
+
+	void InputLatency::Reset() {
+		hasPending = false;
+		samples = 0;
+		totalMs = 0.0;
+		maxMs = 0.0;
+		lastMs = 0.0;
+	}
+}
\ No newline at end of file
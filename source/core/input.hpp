@@ -0,0 +1,84 @@
+#pragma once
+#include "spsc_queue.hpp"
+#include <switch.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace core {
+	typedef std::chrono::steady_clock InputClock;
+
+	enum class InputEventType : uint8_t {
+		Down,
+		Up
+	};
+
+	struct InputEvent {
+		uint64_t buttons;	// HidNpadButton_* bits that changed, all in the same direction
+		InputEventType type;
+		InputClock::time_point timestamp;	// When the polling thread saw the edge
+	};
+
+	// Polls the default gamepad on a dedicated thread, at a much higher rate than the frame
+	// rate, and hands timestamped button edges to the game loop through an SPSC queue. The
+	// game loop only drains the queue, it never touches the PadState itself.
+	// Horizon does not time-slice threads of equal priority, so the polling thread runs on
+	// core 2 at a higher priority than the main thread and the job workers, which it preempts
+	// for the few microseconds a poll takes.
+	class InputPoller {
+	public:
+		static constexpr size_t QueueCapacity = 256;
+	protected:
+		PadState pad;
+		SpscQueue<InputEvent, QueueCapacity> events;
+		Thread thread;
+		std::atomic<bool> running;
+		std::chrono::microseconds interval;
+		std::atomic<uint64_t> dropped;
+
+		void Run();
+		static void ThreadEntry(void* poller);
+		void Push(uint64_t buttons, InputEventType type, InputClock::time_point now);
+	public:
+		InputPoller(std::chrono::microseconds interval = std::chrono::microseconds(1000));
+		InputPoller(const InputPoller&) = delete;
+		InputPoller& operator=(const InputPoller&) = delete;
+
+		// padConfigureInput() must have been called before
+		bool Start();
+		void Stop();
+
+		// Game loop side, returns false once the queue is empty
+		inline bool Poll(InputEvent& out) { return events.Pop(out); }
+
+		// Edges lost because the game loop did not drain the queue in time
+		inline uint64_t DroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+		~InputPoller();
+	};
+
+	// Input-to-present latency: the time between the polling thread seeing a press and the
+	// eglSwapBuffers() call of the first frame that handled it. Only the oldest press handled
+	// in a frame counts, later ones in the same frame are strictly faster.
+	class InputLatency {
+	protected:
+		InputClock::time_point pending;
+		bool hasPending;
+
+		uint64_t samples;
+		double totalMs;
+		double maxMs;
+		double lastMs;
+	public:
+		InputLatency();
+
+		void Handled(const InputEvent& event);
+		void Presented(InputClock::time_point now = InputClock::now());
+		void Reset();
+
+		inline uint64_t Samples() const { return samples; }
+		inline double AverageMs() const { return samples > 0 ? totalMs / samples : 0.0; }
+		inline double MaxMs() const { return maxMs; }
+		inline double LastMs() const { return lastMs; }
+	};
+}
\ No newline at end of file
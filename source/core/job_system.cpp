@@ -0,0 +1,242 @@
+#include "job_system.hpp"
+#include "log.hpp"
+
+namespace core {
+	namespace {
+		// Worker stack size on the console, searches recurse a few KB per ply
+		constexpr size_t WorkerStackSize = 256 * 1024;
+		// Failed attempts to find a job before an idle worker goes to sleep
+		constexpr unsigned int IdleSpins = 64;
+
+		thread_local const JobSystem* currentSystem = nullptr;
+		thread_local unsigned int currentIndex = 0;
+
+		inline void YieldThread() {
+#ifdef __SWITCH__
+			svcSleepThread(0);
+#else
+			std::this_thread::yield();
+#endif
+		}
+	}
+
+	unsigned int JobSystem::DefaultThreadCount() {
+#ifdef __SWITCH__
+		return 2;
+#else
+		unsigned int hardware = std::thread::hardware_concurrency();
+		return hardware > 1 ? hardware - 1 : 0;
+#endif
+	}
+
+	JobSystem::JobSystem(unsigned int threadCount) : workerCount(std::min(threadCount + 1, MaxWorkers)), running(true), queued(0), sleeping(0) {
+		workers.reset(new Worker[workerCount]);
+		for (unsigned int i = 0; i < workerCount; i++) {
+			workers[i].system = this;
+			workers[i].index = i;
+			workers[i].random = i * 2654435761u + 1;
+		}
+
+		currentSystem = this;
+		currentIndex = 0;
+
+#ifdef __SWITCH__
+		s32 priority = 0x2C;
+		svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+		for (unsigned int i = 1; i < workerCount; i++) {
+			// The main thread runs on core 0, workers get the other application cores
+			Result rc = threadCreate(&workers[i].thread, &JobSystem::WorkerEntry, &workers[i], nullptr, WorkerStackSize, priority, i % 3);
+			if (R_SUCCEEDED(rc)) {
+				rc = threadStart(&workers[i].thread);
+				if (R_FAILED(rc)) {
+					threadClose(&workers[i].thread);
+				}
+			}
+			if (R_FAILED(rc)) {
+				LOG_ERROR("JOBS", "Failed to start worker %u: 0x%x", i, rc);
+				workerCount = i;
+				break;
+			}
+		}
+#else
+		for (unsigned int i = 1; i < workerCount; i++) {
+			workers[i].thread = std::thread(&JobSystem::WorkerEntry, &workers[i]);
+		}
+#endif
+		LOG_INFO("JOBS", "%u workers", workerCount);
+	}
+
+	JobSystem::Worker* JobSystem::Current() const {
+		return currentSystem == this ? &workers[currentIndex] : nullptr;
+	}
+
+	unsigned int JobSystem::CurrentWorker() const {
+		return currentSystem == this ? currentIndex : 0;
+	}
+
+	Job* JobSystem::Allocate(void (*function)(Job&), Job* parent) {
+		Worker* current = Current();
+		Worker& worker = current != nullptr ? *current : workers[0];
+
+		// A job still in flight after a full turn of the ring has to finish before its slot
+		// is reused
+		Job* job = &worker.jobs[worker.nextJob++ & (JobsPerWorker - 1)];
+		while (!job->IsFinished()) {
+			Job* other = Take(worker);
+			if (other != nullptr) {
+				Execute(other);
+			} else {
+				YieldThread();
+			}
+		}
+
+		job->function = function;
+		job->parent = parent;
+		job->continuationCount.store(0, std::memory_order_relaxed);
+		job->unfinished.store(1, std::memory_order_relaxed);
+		if (parent != nullptr) {
+			parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+		}
+		return job;
+	}
+
+	bool JobSystem::AddContinuation(Job* ancestor, Job* continuation) {
+		uint32_t index = ancestor->continuationCount.fetch_add(1, std::memory_order_relaxed);
+		if (index >= Job::MaxContinuations) {
+			ancestor->continuationCount.fetch_sub(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		ancestor->continuations[index] = continuation;
+		return true;
+	}
+
+	void JobSystem::Run(Job* job) {
+		Worker* worker = Current();
+		if (worker == nullptr || !worker->queue.Push(job)) {
+			Execute(job);
+			return;
+		}
+
+		// Pairs with Sleep(): either the sleeper sees the job count or this sees the sleeper
+		queued.fetch_add(1, std::memory_order_seq_cst);
+		if (sleeping.load(std::memory_order_seq_cst) > 0) {
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wake.notify_one();
+		}
+	}
+
+	void JobSystem::Wait(const Job* job) {
+		Worker* worker = Current();
+		while (!job->IsFinished()) {
+			Job* other = worker != nullptr ? Take(*worker) : nullptr;
+			if (other != nullptr) {
+				Execute(other);
+			} else {
+				YieldThread();
+			}
+		}
+	}
+
+	Job* JobSystem::Take(Worker& worker) {
+		Job* job;
+		if (worker.queue.Pop(job)) {
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+
+		// Xorshift, only spreads the thieves over the victims
+		worker.random ^= worker.random << 13;
+		worker.random ^= worker.random >> 17;
+		worker.random ^= worker.random << 5;
+		unsigned int start = worker.random % workerCount;
+		for (unsigned int i = 0; i < workerCount; i++) {
+			Worker& victim = workers[(start + i) % workerCount];
+			if (&victim != &worker && victim.queue.Steal(job)) {
+				queued.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::Execute(Job* job) {
+		job->function(*job);
+		Finish(job);
+	}
+
+	void JobSystem::Finish(Job* job) {
+		// Once the count reaches 0 the slot may be reused, so everything needed afterwards is
+		// read first
+		Job* parent = job->parent;
+		uint32_t continuationCount = std::min<uint32_t>(job->continuationCount.load(std::memory_order_relaxed), Job::MaxContinuations);
+		Job* continuations[Job::MaxContinuations];
+		for (uint32_t i = 0; i < continuationCount; i++) {
+			continuations[i] = job->continuations[i];
+		}
+
+		if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+			return;
+		}
+
+		for (uint32_t i = 0; i < continuationCount; i++) {
+			Run(continuations[i]);
+		}
+		if (parent != nullptr) {
+			Finish(parent);
+		}
+	}
+
+	void JobSystem::Sleep() {
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleeping.fetch_add(1, std::memory_order_seq_cst);
+		wake.wait(lock, [this]() { return queued.load(std::memory_order_seq_cst) > 0 || !running.load(std::memory_order_relaxed); });
+		sleeping.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void JobSystem::WorkerLoop(Worker& worker) {
+		currentSystem = this;
+		currentIndex = worker.index;
+
+		unsigned int idle = 0;
+		while (running.load(std::memory_order_relaxed)) {
+			Job* job = Take(worker);
+			if (job != nullptr) {
+				Execute(job);
+				idle = 0;
+			} else if (++idle < IdleSpins) {
+				YieldThread();
+			} else {
+				Sleep();
+				idle = 0;
+			}
+		}
+	}
+
+	void JobSystem::WorkerEntry(void* worker) {
+		Worker* self = static_cast<Worker*>(worker);
+		self->system->WorkerLoop(*self);
+	}
+
+	JobSystem::~JobSystem() {
+		running.store(false, std::memory_order_relaxed);
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wake.notify_all();
+		}
+
+		for (unsigned int i = 1; i < workerCount; i++) {
+#ifdef __SWITCH__
+			threadWaitForExit(&workers[i].thread);
+			threadClose(&workers[i].thread);
+#else
+			workers[i].thread.join();
+#endif
+		}
+
+		if (currentSystem == this) {
+			currentSystem = nullptr;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#pragma once
+#include "work_stealing_deque.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SWITCH__
+#include <switch.h>
+#else
+#include <thread>
+#endif
+
+namespace core {
+	class JobSystem;
+
+	// A unit of work: a callable stored in place, the number of unfinished jobs it waits for
+	// (itself and its children) and the jobs to start once it is done. Jobs come from
+	// fixed per-worker rings, see JobSystem.
+	struct alignas(64) Job {
+		static constexpr unsigned int MaxContinuations = 4;
+		static constexpr size_t PayloadSize = 64;
+
+		void (*function)(Job& job);
+		Job* parent;
+		std::atomic<int32_t> unfinished;
+		std::atomic<uint32_t> continuationCount;
+		Job* continuations[MaxContinuations];
+		alignas(16) unsigned char payload[PayloadSize];
+
+		Job() : function(nullptr), parent(nullptr), unfinished(0), continuationCount(0), continuations() {}
+
+		inline bool IsFinished() const { return unfinished.load(std::memory_order_acquire) <= 0; }
+	};
+
+	// Work-stealing job system shared by every subsystem that wants to spread work over the
+	// cores, instead of each one starting its own threads.
+	//
+	// Every worker owns a Chase-Lev deque: it pushes and pops its own jobs at one end (newest
+	// first, which keeps a job's children in cache), idle workers steal the oldest jobs from the
+	// other end of a random victim. The thread that creates the system is worker 0 and only
+	// runs jobs while it waits for one (Wait(), ParallelFor()), the other workers sleep when
+	// there is nothing to run. Workers are std::threads on hosts and libnx threads pinned to
+	// their own core on the console (the main thread keeps core 0).
+	//
+	//   core::Job* root = jobs.Create([]() {});
+	//   jobs.Run(jobs.Create([&]() { Work(0); }, root));
+	//   jobs.Run(jobs.Create([&]() { Work(1); }, root));
+	//   jobs.Run(root);
+	//   jobs.Wait(root);	// Both Work() calls are done
+	//
+	// Jobs may only be created, run and waited for by the workers (the creating thread and
+	// jobs running on the system). A worker has JobsPerWorker jobs in flight at most, its ring
+	// wraps around after that.
+	class JobSystem {
+	public:
+		static constexpr unsigned int MaxWorkers = 16;
+		static constexpr unsigned int JobsPerWorker = 4096;
+		static constexpr size_t QueueCapacity = 4096;
+		// Ranges a ParallelFor is split in at most
+		static constexpr uint32_t MaxRanges = 1024;
+	protected:
+		struct alignas(64) Worker {
+			WorkStealingDeque<Job*, QueueCapacity> queue;
+			std::unique_ptr<Job[]> jobs;
+			uint32_t nextJob;
+			uint32_t random;
+#ifdef __SWITCH__
+			Thread thread;
+#else
+			std::thread thread;
+#endif
+			JobSystem* system;
+			unsigned int index;
+
+			Worker() : jobs(new Job[JobsPerWorker]), nextJob(0), random(0), system(nullptr), index(0) {}
+		};
+
+		std::unique_ptr<Worker[]> workers;
+		unsigned int workerCount;
+		std::atomic<bool> running;
+
+		// Jobs pushed and not taken yet, idle workers sleep while it is 0
+		std::atomic<int32_t> queued;
+		std::atomic<uint32_t> sleeping;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+
+		Job* Allocate(void (*function)(Job&), Job* parent);
+		Job* Take(Worker& worker);
+		void Execute(Job* job);
+		void Finish(Job* job);
+		void Sleep();
+		void WorkerLoop(Worker& worker);
+		static void WorkerEntry(void* worker);
+		// Worker of the calling thread in this system, nullptr for other threads
+		Worker* Current() const;
+
+		template<typename Fn>
+		static void Invoke(Job& job) {
+			Fn* fn = reinterpret_cast<Fn*>(job.payload);
+			(*fn)();
+			fn->~Fn();
+		}
+	public:
+		// Background threads besides the creating one: hardware threads - 1 on hosts, the two
+		// cores left to applications besides the main thread on the console
+		static unsigned int DefaultThreadCount();
+
+		explicit JobSystem(unsigned int threadCount = DefaultThreadCount());
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Creates a job calling fn() (which must fit Job::PayloadSize). With a parent, the parent
+		// only finishes once this job has, so children must be created before their parent
+		// finishes. The job does nothing until Run().
+		template<typename Fn>
+		Job* Create(Fn&& fn, Job* parent = nullptr) {
+			typedef typename std::decay<Fn>::type Stored;
+			static_assert(sizeof(Stored) <= Job::PayloadSize && alignof(Stored) <= 16, "Job captures are too large");
+
+			Job* job = Allocate(&Invoke<Stored>, parent);
+			new (job->payload) Stored(std::forward<Fn>(fn));
+			return job;
+		}
+
+		// Runs continuation once ancestor (and its children) finished. Must be called before
+		// ancestor or any of its children runs, false when it already has
+		// Job::MaxContinuations.
+		bool AddContinuation(Job* ancestor, Job* continuation);
+
+		// Queues job on the calling worker, or runs it at once when the queue is full
+		void Run(Job* job);
+		// Runs other jobs until job finished
+		void Wait(const Job* job);
+
+		// Calls fn(begin, end) on ranges of up to grain items covering [0, count), spread over
+		// the workers, and returns once all of them are done. The calling thread helps.
+		template<typename Fn>
+		void ParallelFor(uint32_t count, uint32_t grain, Fn fn) {
+			if (count == 0) {
+				return;
+			}
+			// Few enough ranges to stay well inside the job ring
+			grain = std::max<uint32_t>(grain, (count + MaxRanges - 1) / MaxRanges);
+			grain = std::max<uint32_t>(grain, 1);
+
+			Job* root = Create([]() {});
+			for (uint32_t begin = 0; begin < count; begin += grain) {
+				uint32_t end = std::min(count, begin + grain);
+				Run(Create([&fn, begin, end]() { fn(begin, end); }, root));
+			}
+			Run(root);
+			Wait(root);
+		}
+
+		// Including the creating thread
+		inline unsigned int WorkerCount() const { return workerCount; }
+		// Index of the calling worker in [0, WorkerCount()), 0 for threads outside the system
+		unsigned int CurrentWorker() const;
+
+		~JobSystem();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "log.hpp"
+#include "mpsc_queue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+
+namespace core {
+	namespace {
+		constexpr size_t RingCapacity = 1024;
+
+		struct LogState {
+			MpscQueue<LogRecord, RingCapacity> ring;
+			std::vector<std::unique_ptr<LogSink>> sinks;
+			std::thread thread;
+			std::atomic<bool> running { false };
+			std::atomic<bool> stopRequested { false };
+			std::atomic<uint64_t> dropped { 0 };
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		};
+
+		LogState& State() {
+			static LogState state;
+			return state;
+		}
+
+		const char* LevelName(LogLevel level) {
+			switch (level) {
+				case LogLevel::Trace:
+					return "T";
+				case LogLevel::Debug:
+					return "D";
+				case LogLevel::Info:
+					return "I";
+				case LogLevel::Warning:
+					return "W";
+				case LogLevel::Error:
+					return "E";
+			}
+			return "?";
+		}
+
+		size_t FormatLine(const LogRecord& record, char* line, size_t capacity) {
+			int written = snprintf(line, capacity, "[%10.4f][%s][%s] %.*s\n",
+				record.timestampNs / 1e9, LevelName(record.level), record.tag, static_cast<int>(record.length), record.message);
+			if (written < 0) {
+				return 0;
+			}
+
+			return static_cast<size_t>(written) < capacity ? static_cast<size_t>(written) : capacity - 1;
+		}
+
+		void FillRecord(LogRecord& record, uint64_t timestamp, LogLevel level, const char* tag, const char* format, va_list args) {
+			record.timestampNs = timestamp;
+			record.tag = tag;
+			record.level = level;
+			int written = vsnprintf(record.message, sizeof(record.message), format, args);
+			if (written < 0) {
+				written = 0;
+			} else if (written >= static_cast<int>(sizeof(record.message))) {
+				written = sizeof(record.message) - 1;
+			}
+			record.length = static_cast<uint8_t>(written);
+		}
+
+		void LogThread() {
+			LogState& state = State();
+			char line[LogRecord::MessageCapacity + 64];
+			LogRecord record;
+
+			for (;;) {
+				bool any = false;
+				while (state.ring.Pop(record)) {
+					size_t length = FormatLine(record, line, sizeof(line));
+					for (auto& sink : state.sinks) {
+						sink->Write(line, length);
+					}
+					any = true;
+				}
+
+				if (any) {
+					for (auto& sink : state.sinks) {
+						sink->Flush();
+					}
+				} else if (state.stopRequested.load(std::memory_order_acquire)) {
+					break;
+				} else {
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				}
+			}
+		}
+	}
+
+	void StdoutSink::Write(const char* line, size_t length) {
+		fwrite(line, 1, length, stdout);
+	}
+
+	void StdoutSink::Flush() {
+		fflush(stdout);
+	}
+
+	FileSink::FileSink(const char* path) : file(fopen(path, "ab")) {
+
+	}
+
+	void FileSink::Write(const char* line, size_t length) {
+		if (file != nullptr) {
+			fwrite(line, 1, length, file);
+		}
+	}
+
+	void FileSink::Flush() {
+		if (file != nullptr) {
+			fflush(file);
+		}
+	}
+
+	FileSink::~FileSink() {
+		if (file != nullptr) {
+			fclose(file);
+			file = nullptr;
+		}
+	}
+
+	SocketSink::SocketSink(int fd) : fd(fd) {
+
+	}
+
+	void SocketSink::Write(const char* line, size_t length) {
+		if (fd >= 0) {
+			send(fd, line, length, 0);
+		}
+	}
+
+	void LogAddSink(std::unique_ptr<LogSink> sink) {
+		LogState& state = State();
+		if (state.running.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		state.sinks.push_back(std::move(sink));
+	}
+
+	bool LogStart() {
+		LogState& state = State();
+		if (state.running.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		if (state.sinks.empty()) {
+			state.sinks.push_back(std::make_unique<StdoutSink>());
+		}
+
+		state.stopRequested.store(false, std::memory_order_release);
+		state.thread = std::thread(LogThread);
+		state.running.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void LogStop() {
+		LogState& state = State();
+		if (!state.running.exchange(false, std::memory_order_acq_rel)) {
+			return;
+		}
+
+		state.stopRequested.store(true, std::memory_order_release);
+		state.thread.join();
+
+		uint64_t dropped = state.dropped.load(std::memory_order_relaxed);
+		if (dropped > 0) {
+			printf("[LOG] %llu records dropped\n", static_cast<unsigned long long>(dropped));
+		}
+	}
+
+	uint64_t LogDroppedCount() {
+		return State().dropped.load(std::memory_order_relaxed);
+	}
+
+	void Log(LogLevel level, const char* tag, const char* format, ...) {
+		LogState& state = State();
+		uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state.start).count();
+
+		va_list args;
+		va_start(args, format);
+
+		if (!state.running.load(std::memory_order_acquire)) {
+			LogRecord record;
+			FillRecord(record, timestamp, level, tag, format, args);
+
+			char line[LogRecord::MessageCapacity + 64];
+			size_t length = FormatLine(record, line, sizeof(line));
+			fwrite(line, 1, length, stdout);
+			va_end(args);
+			return;
+		}
+
+		bool pushed = state.ring.Emplace([&](LogRecord& record) {
+			FillRecord(record, timestamp, level, tag, format, args);
+		});
+		va_end(args);
+
+		if (!pushed) {
+			state.dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
\ No newline at end of file
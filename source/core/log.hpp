@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+// Compile-time log filtering: every LOG_* call below LOG_MIN_LEVEL compiles to nothing,
+// including the evaluation of its arguments.
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_NONE 5
+
+#ifndef LOG_MIN_LEVEL
+#ifdef DEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+#define LOG_AT(level, tag, ...) do { \
+		if (static_cast<int>(level) >= LOG_MIN_LEVEL) { \
+			::core::Log(level, tag, __VA_ARGS__); \
+		} \
+	} while (0)
+
+// tag must be a string literal, only its pointer is stored in the record
+#define LOG_TRACE(tag, ...) LOG_AT(::core::LogLevel::Trace, tag, __VA_ARGS__)
+#define LOG_DEBUG(tag, ...) LOG_AT(::core::LogLevel::Debug, tag, __VA_ARGS__)
+#define LOG_INFO(tag, ...) LOG_AT(::core::LogLevel::Info, tag, __VA_ARGS__)
+#define LOG_WARN(tag, ...) LOG_AT(::core::LogLevel::Warning, tag, __VA_ARGS__)
+#define LOG_ERROR(tag, ...) LOG_AT(::core::LogLevel::Error, tag, __VA_ARGS__)
+
+namespace core {
+	enum class LogLevel : uint8_t {
+		Trace = LOG_LEVEL_TRACE,
+		Debug = LOG_LEVEL_DEBUG,
+		Info = LOG_LEVEL_INFO,
+		Warning = LOG_LEVEL_WARNING,
+		Error = LOG_LEVEL_ERROR
+	};
+
+	// Fixed-size record written by the caller straight into the log ring.
+	// The message is formatted on the calling thread, everything else is plain binary data.
+	struct LogRecord {
+		static constexpr size_t MessageCapacity = 104;
+
+		uint64_t timestampNs;
+		const char* tag;
+		LogLevel level;
+		uint8_t length;
+		char message[MessageCapacity];
+	};
+
+	// Destination for formatted log lines. Only ever called from the logging thread.
+	class LogSink {
+	public:
+		virtual void Write(const char* line, size_t length) = 0;
+		virtual void Flush() {}
+		virtual ~LogSink() {}
+	};
+
+	class StdoutSink : public LogSink {
+	public:
+		void Write(const char* line, size_t length) override;
+		void Flush() override;
+	};
+
+	class FileSink : public LogSink {
+	protected:
+		FILE* file;
+	public:
+		FileSink(const char* path);
+		FileSink(const FileSink&) = delete;
+		FileSink& operator=(const FileSink&) = delete;
+
+		inline bool IsOpen() const { return file != nullptr; }
+
+		void Write(const char* line, size_t length) override;
+		void Flush() override;
+
+		~FileSink();
+	};
+
+	// Writes to an already connected socket, the sink does not own the descriptor
+	class SocketSink : public LogSink {
+	protected:
+		int fd;
+	public:
+		SocketSink(int fd);
+
+		void Write(const char* line, size_t length) override;
+	};
+
+	// Sinks must be added before LogStart(). Until the logging thread is running (and after
+	// LogStop()) records are written synchronously to stdout.
+	void LogAddSink(std::unique_ptr<LogSink> sink);
+	bool LogStart();
+	void LogStop();
+
+	// Records dropped because the ring was full
+	uint64_t LogDroppedCount();
+
+	void Log(LogLevel level, const char* tag, const char* format, ...) __attribute__((format(printf, 3, 4)));
+}
\ No newline at end of file
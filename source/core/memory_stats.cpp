@@ -0,0 +1,146 @@
+#include "memory_stats.hpp"
+#include "log.hpp"
+#include <atomic>
+
+namespace core {
+	namespace {
+		struct Counter {
+			std::atomic<uint64_t> current { 0 };
+			std::atomic<uint64_t> peak { 0 };
+			std::atomic<uint64_t> allocations { 0 };
+			std::atomic<uint64_t> budget { 0 };
+		};
+
+		struct MemoryState {
+			Counter categories[MemoryCategoryCount];
+			Counter total;
+		};
+
+		MemoryState& State() {
+			static MemoryState state;
+			return state;
+		}
+
+		void RaisePeak(std::atomic<uint64_t>& peak, uint64_t value) {
+			uint64_t previous = peak.load(std::memory_order_relaxed);
+			while (value > previous && !peak.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+			}
+		}
+
+		double Megabytes(uint64_t bytes) {
+			return bytes / (1024.0 * 1024.0);
+		}
+	}
+
+	const char* MemoryCategoryName(MemoryCategory category) {
+		switch (category) {
+			case MemoryCategory::TextureRGBA8:
+				return "Texture RGBA8";
+			case MemoryCategory::TextureCompressed:
+				return "Texture compressed";
+			case MemoryCategory::TextureR8:
+				return "Texture R8";
+			case MemoryCategory::Renderbuffer:
+				return "Renderbuffer";
+			case MemoryCategory::BufferStatic:
+				return "Buffer static";
+			case MemoryCategory::BufferDynamic:
+				return "Buffer dynamic";
+			case MemoryCategory::BufferStream:
+				return "Buffer stream";
+			case MemoryCategory::DecodeScratch:
+				return "Decode scratch";
+			case MemoryCategory::Count:
+				break;
+		}
+		return "?";
+	}
+
+	void MemorySetBudget(MemoryCategory category, uint64_t bytes) {
+		State().categories[static_cast<size_t>(category)].budget.store(bytes, std::memory_order_relaxed);
+	}
+
+	void MemorySetTotalBudget(uint64_t bytes) {
+		State().total.budget.store(bytes, std::memory_order_relaxed);
+	}
+
+	bool MemoryWouldFit(MemoryCategory category, uint64_t bytes) {
+		MemoryState& state = State();
+		const Counter& counter = state.categories[static_cast<size_t>(category)];
+
+		uint64_t budget = counter.budget.load(std::memory_order_relaxed);
+		if (budget != 0 && counter.current.load(std::memory_order_relaxed) + bytes > budget) {
+			return false;
+		}
+
+		uint64_t totalBudget = state.total.budget.load(std::memory_order_relaxed);
+		return totalBudget == 0 || state.total.current.load(std::memory_order_relaxed) + bytes <= totalBudget;
+	}
+
+	void MemoryAllocated(MemoryCategory category, uint64_t bytes) {
+		MemoryState& state = State();
+		Counter& counter = state.categories[static_cast<size_t>(category)];
+
+		uint64_t current = counter.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		counter.allocations.fetch_add(1, std::memory_order_relaxed);
+		RaisePeak(counter.peak, current);
+
+		uint64_t total = state.total.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		state.total.allocations.fetch_add(1, std::memory_order_relaxed);
+		RaisePeak(state.total.peak, total);
+
+		// Warn on the allocation that crosses a budget, not on every one after it
+		uint64_t budget = counter.budget.load(std::memory_order_relaxed);
+		if (budget != 0 && current > budget && current - bytes <= budget) {
+			LOG_WARN("MEM", "%s over budget: %.2f MB of %.2f MB", MemoryCategoryName(category), Megabytes(current), Megabytes(budget));
+		}
+
+		uint64_t totalBudget = state.total.budget.load(std::memory_order_relaxed);
+		if (totalBudget != 0 && total > totalBudget && total - bytes <= totalBudget) {
+			LOG_WARN("MEM", "Total memory over budget: %.2f MB of %.2f MB", Megabytes(total), Megabytes(totalBudget));
+		}
+	}
+
+	void MemoryFreed(MemoryCategory category, uint64_t bytes) {
+		MemoryState& state = State();
+		Counter& counter = state.categories[static_cast<size_t>(category)];
+
+		counter.current.fetch_sub(bytes, std::memory_order_relaxed);
+		counter.allocations.fetch_sub(1, std::memory_order_relaxed);
+		state.total.current.fetch_sub(bytes, std::memory_order_relaxed);
+		state.total.allocations.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	MemorySnapshot MemoryGetSnapshot() {
+		MemoryState& state = State();
+		MemorySnapshot snapshot;
+		for (size_t i = 0; i < MemoryCategoryCount; i++) {
+			const Counter& counter = state.categories[i];
+			snapshot.categories[i] = MemoryCategoryStats {
+				counter.current.load(std::memory_order_relaxed),
+				counter.peak.load(std::memory_order_relaxed),
+				counter.allocations.load(std::memory_order_relaxed),
+				counter.budget.load(std::memory_order_relaxed)
+			};
+		}
+		snapshot.totalCurrent = state.total.current.load(std::memory_order_relaxed);
+		snapshot.totalPeak = state.total.peak.load(std::memory_order_relaxed);
+		snapshot.totalBudget = state.total.budget.load(std::memory_order_relaxed);
+		return snapshot;
+	}
+
+	void MemoryLogSnapshot() {
+		MemorySnapshot snapshot = MemoryGetSnapshot();
+		LOG_INFO("MEM", "%-18s %9s %9s %9s %6s", "Category", "MB", "Peak MB", "Budget", "Allocs");
+		for (size_t i = 0; i < MemoryCategoryCount; i++) {
+			const MemoryCategoryStats& stats = snapshot.categories[i];
+			if (stats.peak == 0) {
+				continue;
+			}
+
+			LOG_INFO("MEM", "%-18s %9.2f %9.2f %9.2f %6llu", MemoryCategoryName(static_cast<MemoryCategory>(i)),
+				Megabytes(stats.current), Megabytes(stats.peak), Megabytes(stats.budget), static_cast<unsigned long long>(stats.allocations));
+		}
+		LOG_INFO("MEM", "%-18s %9.2f %9.2f %9.2f", "Total", Megabytes(snapshot.totalCurrent), Megabytes(snapshot.totalPeak), Megabytes(snapshot.totalBudget));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Memory accounting for GPU resources and large CPU scratch allocations. Owners report what
+// they allocate and free per category; current and high-water values are tracked per
+// category and in total, and optional budgets log a warning when an allocation crosses them.
+// Counters are atomic, so reporting from loader threads is fine.
+
+namespace core {
+	enum class MemoryCategory : uint8_t {
+		TextureRGBA8,		// Uncompressed RGBA textures, including render targets
+		TextureCompressed,	// GL_COMPRESSED_* textures, counted at their uncompressed size
+		TextureR8,			// Single channel textures (glyph atlases, masks)
+		Renderbuffer,		// Depth/stencil attachments
+		BufferStatic,		// GL_STATIC_* buffers
+		BufferDynamic,		// GL_DYNAMIC_* buffers
+		BufferStream,		// GL_STREAM_* buffers
+		DecodeScratch,		// CPU memory used while decoding assets
+		Count
+	};
+
+	constexpr size_t MemoryCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+	const char* MemoryCategoryName(MemoryCategory category);
+
+	struct MemoryCategoryStats {
+		uint64_t current;
+		uint64_t peak;
+		uint64_t allocations;	// Live allocations
+		uint64_t budget;		// 0 when unlimited
+	};
+
+	struct MemorySnapshot {
+		MemoryCategoryStats categories[MemoryCategoryCount];
+		uint64_t totalCurrent;
+		uint64_t totalPeak;
+		uint64_t totalBudget;
+	};
+
+	// Budgets only warn, allocations are never refused. 0 removes the budget.
+	void MemorySetBudget(MemoryCategory category, uint64_t bytes);
+	void MemorySetTotalBudget(uint64_t bytes);
+
+	// True when bytes more in category would stay within both its budget and the total budget.
+	// Loaders call this before allocating to warn about the asset that breaks the budget.
+	bool MemoryWouldFit(MemoryCategory category, uint64_t bytes);
+
+	void MemoryAllocated(MemoryCategory category, uint64_t bytes);
+	void MemoryFreed(MemoryCategory category, uint64_t bytes);
+
+	MemorySnapshot MemoryGetSnapshot();
+	// Logs one line per category with current/peak/budget values
+	void MemoryLogSnapshot();
+
+	// Accounts bytes of category for the lifetime of the object
+	class ScopedMemory {
+	protected:
+		MemoryCategory category;
+		uint64_t bytes;
+	public:
+		inline ScopedMemory(MemoryCategory category, uint64_t bytes) : category(category), bytes(bytes) {
+			MemoryAllocated(category, bytes);
+		}
+		ScopedMemory(const ScopedMemory&) = delete;
+		ScopedMemory& operator=(const ScopedMemory&) = delete;
+
+		inline ~ScopedMemory() {
+			MemoryFreed(category, bytes);
+		}
+	};
+}
\ No newline at end of file
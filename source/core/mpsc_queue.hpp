@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+	// Bounded lock-free multi-producer / single-consumer queue (Vyukov's sequenced ring).
+	// Producers claim a cell with a single CAS and fill it in place, nothing ever blocks and a
+	// full queue is reported to the producer instead of waiting for the consumer.
+	template<typename T, size_t Capacity>
+	class MpscQueue {
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+	protected:
+		struct Cell {
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		alignas(64) Cell cells[Capacity];
+		alignas(64) std::atomic<size_t> enqueuePos;
+		alignas(64) size_t dequeuePos;
+	public:
+		MpscQueue() : enqueuePos(0), dequeuePos(0) {
+			for (size_t i = 0; i < Capacity; i++) {
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue& operator=(const MpscQueue&) = delete;
+
+		// Claims a cell and hands it to fill(T&) before publishing it. Returns false when full.
+		template<typename Fill>
+		bool Emplace(Fill&& fill) {
+			size_t pos = enqueuePos.load(std::memory_order_relaxed);
+			Cell* cell;
+			for (;;) {
+				cell = &cells[pos & (Capacity - 1)];
+				size_t seq = cell->sequence.load(std::memory_order_acquire);
+				intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0) {
+					if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return false;
+				} else {
+					pos = enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+
+			fill(cell->value);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Push(const T& value) {
+			return Emplace([&value](T& target) { target = value; });
+		}
+
+		// Consumer side only
+		bool Pop(T& out) {
+			Cell& cell = cells[dequeuePos & (Capacity - 1)];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			if (seq != dequeuePos + 1) {
+				return false;
+			}
+
+			out = cell.value;
+			cell.sequence.store(dequeuePos + Capacity, std::memory_order_release);
+			dequeuePos++;
+			return true;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "resolution_controller.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace core {
+	ResolutionController::ResolutionController(double targetMs, float minScale, float maxScale) :
+		targetMs(targetMs), minScale(minScale), maxScale(maxScale), scale(maxScale), smoothedMs(0.0), hasSample(false), samplesSinceChange(0) {
+
+	}
+
+	void ResolutionController::SetTarget(double targetMs) {
+		this->targetMs = targetMs;
+		samplesSinceChange = SettleSamples;
+	}
+
+	float ResolutionController::Update(double gpuMs) {
+		samplesSinceChange++;
+		if (gpuMs <= 0.0 || samplesSinceChange <= SettleSamples) {
+			return scale;
+		}
+
+		// Spikes over budget are followed immediately, improvements are averaged in slowly
+		if (!hasSample || gpuMs > smoothedMs) {
+			smoothedMs = hasSample ? (smoothedMs + gpuMs) / 2.0 : gpuMs;
+		} else {
+			smoothedMs += (gpuMs - smoothedMs) * 0.1;
+		}
+		hasSample = true;
+
+		float wanted = scale * static_cast<float>(std::sqrt(targetMs / smoothedMs));
+		wanted = std::min(std::max(wanted, minScale), maxScale);
+
+		float quantized = scale;
+		if (wanted < scale - Step / 2) {
+			quantized = std::max(std::floor(wanted / Step) * Step, minScale);
+		} else if (wanted >= scale + Step && samplesSinceChange >= GrowDelay) {
+			quantized = std::min(scale + Step, maxScale);
+		}
+
+		if (quantized != scale) {
+			// The smoothed time was measured at the old scale, rescale it to the new pixel count
+			smoothedMs *= (quantized * quantized) / (scale * scale);
+			scale = quantized;
+			samplesSinceChange = 0;
+		}
+
+		return scale;
+	}
+
+	void ResolutionController::Reset() {
+		scale = maxScale;
+		smoothedMs = 0.0;
+		hasSample = false;
+		samplesSinceChange = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+namespace core {
+	// Picks the internal render scale that keeps the GPU frame time under a target.
+	// GPU time is assumed to grow with the pixel count, so the scale needed to hit the target
+	// is current * sqrt(target / measured). Measurements are smoothed, the scale drops as soon
+	// as the GPU goes over budget but only grows back in small steps after a quiet period, so
+	// the resolution does not oscillate around the target.
+	class ResolutionController {
+	public:
+		static constexpr float Step = 1.0f / 32.0f;
+		static constexpr unsigned int GrowDelay = 30;
+		// Measurements arrive a few frames late, the ones still in flight after a change were
+		// taken at the old scale and are ignored
+		static constexpr unsigned int SettleSamples = 4;
+	protected:
+		double targetMs;
+		float minScale;
+		float maxScale;
+		float scale;
+		double smoothedMs;
+		bool hasSample;
+		unsigned int samplesSinceChange;
+	public:
+		ResolutionController(double targetMs = 14.0, float minScale = 0.5f, float maxScale = 1.0f);
+
+		void SetTarget(double targetMs);
+		inline double Target() const { return targetMs; }
+
+		// Feeds the GPU time of a frame rendered at Scale(), returns the scale of the next frames
+		float Update(double gpuMs);
+		// Forgets the measurements and goes back to the maximum scale, after the output size changed
+		void Reset();
+
+		inline float Scale() const { return scale; }
+		inline double SmoothedMs() const { return smoothedMs; }
+	};
+}
\ No newline at end of file
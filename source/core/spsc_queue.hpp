@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+namespace core {
+	// Bounded lock-free single-producer / single-consumer ring. Each side owns one index and
+	// keeps a cached copy of the other one, so the shared cache lines are only touched when the
+	// cached copy says the ring looks full (producer) or empty (consumer).
+	template<typename T, size_t Capacity>
+	class SpscQueue {
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+	protected:
+		T cells[Capacity];
+
+		alignas(64) std::atomic<size_t> head;	// Next cell to read, written by the consumer
+		size_t cachedTail;
+
+		alignas(64) std::atomic<size_t> tail;	// Next cell to write, written by the producer
+		size_t cachedHead;
+	public:
+		SpscQueue() : head(0), cachedTail(0), tail(0), cachedHead(0) {}
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		// Producer side only, returns false when full
+		bool Push(const T& value) {
+			size_t pos = tail.load(std::memory_order_relaxed);
+			if (pos - cachedHead == Capacity) {
+				cachedHead = head.load(std::memory_order_acquire);
+				if (pos - cachedHead == Capacity) {
+					return false;
+				}
+			}
+
+			cells[pos & (Capacity - 1)] = value;
+			tail.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side only, returns false when empty
+		bool Pop(T& out) {
+			size_t pos = head.load(std::memory_order_relaxed);
+			if (pos == cachedTail) {
+				cachedTail = tail.load(std::memory_order_acquire);
+				if (pos == cachedTail) {
+					return false;
+				}
+			}
+
+			out = cells[pos & (Capacity - 1)];
+			head.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "trace.hpp"
+
+#ifdef ENABLE_TRACING
+#include "log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace core {
+	namespace {
+		enum class TraceEventType : uint8_t {
+			Begin,
+			End,
+			Counter,
+			Frame
+		};
+
+		struct TraceEvent {
+			uint64_t timestampNs;
+			const char* name;
+			int64_t value;
+			TraceEventType type;
+		};
+
+		// Per-thread ring of events. Only the owning thread writes, the exporter copies the last
+		// Capacity events published through count and keeps the ones the owner cannot have
+		// overwritten while they were copied.
+		struct ThreadBuffer {
+			static constexpr size_t Capacity = 1 << 15;
+
+			uint32_t tid;
+			const char* name;
+			std::unique_ptr<TraceEvent[]> events;
+			std::atomic<uint64_t> count;
+
+			ThreadBuffer(uint32_t tid) : tid(tid), name(nullptr), events(new TraceEvent[Capacity]), count(0) {}
+		};
+
+		struct TraceState {
+			std::mutex mutex;
+			std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+			std::atomic<uint64_t> frame { 0 };
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		};
+
+		TraceState& State() {
+			static TraceState state;
+			return state;
+		}
+
+		ThreadBuffer& LocalBuffer() {
+			thread_local ThreadBuffer* buffer = nullptr;
+			if (buffer == nullptr) {
+				TraceState& state = State();
+				std::lock_guard<std::mutex> lock(state.mutex);
+				state.buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(state.buffers.size() + 1)));
+				buffer = state.buffers.back().get();
+			}
+			return *buffer;
+		}
+
+		inline void Record(TraceEventType type, const char* name, int64_t value) {
+			TraceState& state = State();
+			ThreadBuffer& buffer = LocalBuffer();
+
+			uint64_t index = buffer.count.load(std::memory_order_relaxed);
+			TraceEvent& event = buffer.events[index & (ThreadBuffer::Capacity - 1)];
+			event.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state.start).count();
+			event.name = name;
+			event.value = value;
+			event.type = type;
+			buffer.count.store(index + 1, std::memory_order_release);
+		}
+
+		// Minimal JSON string escaping, names are literals so this is mostly a formality
+		void WriteName(FILE* file, const char* name) {
+			fputc('"', file);
+			for (const char* c = name; *c != '\0'; c++) {
+				if (*c == '"' || *c == '\\') {
+					fputc('\\', file);
+				}
+				fputc(*c, file);
+			}
+			fputc('"', file);
+		}
+	}
+
+	void TraceBegin(const char* name) {
+		Record(TraceEventType::Begin, name, 0);
+	}
+
+	void TraceEnd(const char* name) {
+		Record(TraceEventType::End, name, 0);
+	}
+
+	void TraceCounter(const char* name, int64_t value) {
+		Record(TraceEventType::Counter, name, value);
+	}
+
+	void TraceFrame() {
+		Record(TraceEventType::Frame, "Frame", static_cast<int64_t>(State().frame.fetch_add(1, std::memory_order_relaxed)));
+	}
+
+	void TraceThreadName(const char* name) {
+		LocalBuffer().name = name;
+	}
+
+	bool TraceExport(const char* path) {
+		TraceState& state = State();
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr) {
+			LOG_ERROR("TRACE", "Failed to open %s", path);
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(state.mutex);
+
+		size_t written = 0;
+		bool first = true;
+		std::vector<TraceEvent> events;
+		events.reserve(ThreadBuffer::Capacity);
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+		for (auto& buffer : state.buffers) {
+			if (buffer->name != nullptr) {
+				fprintf(file, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", first ? "" : ",\n", buffer->tid);
+				WriteName(file, buffer->name);
+				fputs("}}", file);
+				first = false;
+			}
+
+			uint64_t count = buffer->count.load(std::memory_order_acquire);
+			uint64_t begin = count > ThreadBuffer::Capacity ? count - ThreadBuffer::Capacity : 0;
+			events.clear();
+			for (uint64_t i = begin; i < count; i++) {
+				events.push_back(buffer->events[i & (ThreadBuffer::Capacity - 1)]);
+			}
+
+			// The owner kept recording during the copy: events up to newCount were published
+			// and the one after may be half written, so every slot they reuse is dropped
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t newCount = buffer->count.load(std::memory_order_relaxed);
+			uint64_t valid = newCount + 1 > ThreadBuffer::Capacity ? newCount + 1 - ThreadBuffer::Capacity : 0;
+			size_t skip = static_cast<size_t>(std::min(std::max(valid, begin) - begin, static_cast<uint64_t>(events.size())));
+
+			// After a wrap the window can start inside zones whose Begin was overwritten
+			unsigned int open = 0;
+			for (size_t e = skip; e < events.size(); e++) {
+				const TraceEvent& event = events[e];
+				if (event.type == TraceEventType::Begin) {
+					open++;
+				} else if (event.type == TraceEventType::End) {
+					if (open == 0) {
+						continue;
+					}
+					open--;
+				}
+				double ts = event.timestampNs / 1000.0;
+
+				fputs(first ? "" : ",\n", file);
+				first = false;
+				fputs("{\"name\":", file);
+				WriteName(file, event.name);
+				switch (event.type) {
+					case TraceEventType::Begin:
+						fprintf(file, ",\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", buffer->tid, ts);
+						break;
+					case TraceEventType::End:
+						fprintf(file, ",\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", buffer->tid, ts);
+						break;
+					case TraceEventType::Counter:
+						fprintf(file, ",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%lld}}", buffer->tid, ts, static_cast<long long>(event.value));
+						break;
+					case TraceEventType::Frame:
+						fprintf(file, ",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"frame\":%lld}}", buffer->tid, ts, static_cast<long long>(event.value));
+						break;
+				}
+				written++;
+			}
+		}
+		fputs("\n]}\n", file);
+		fclose(file);
+
+		LOG_INFO("TRACE", "Exported %zu events to %s", written, path);
+		return true;
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+// Scoped tracing zones, counters and frame markers, exported as Chrome trace-event JSON
+// (open the file in Perfetto or chrome://tracing). Everything compiles to nothing unless
+// ENABLE_TRACING is defined.
+//
+// Names must be string literals, only their pointers are recorded.
+
+#ifdef ENABLE_TRACING
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_ZONE(name) ::core::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_COUNTER(name, value) ::core::TraceCounter(name, static_cast<int64_t>(value))
+#define TRACE_FRAME() ::core::TraceFrame()
+#define TRACE_THREAD_NAME(name) ::core::TraceThreadName(name)
+#define TRACE_EXPORT(path) ::core::TraceExport(path)
+
+namespace core {
+	void TraceBegin(const char* name);
+	void TraceEnd(const char* name);
+	void TraceCounter(const char* name, int64_t value);
+	void TraceFrame();
+	void TraceThreadName(const char* name);
+
+	// Writes every recorded event of every thread to path. Threads keep recording while the
+	// export runs, so events written during the export may or may not be part of it.
+	bool TraceExport(const char* path);
+
+	class TraceZone {
+	protected:
+		const char* name;
+	public:
+		inline TraceZone(const char* name) : name(name) {
+			TraceBegin(name);
+		}
+		TraceZone(const TraceZone&) = delete;
+		TraceZone& operator=(const TraceZone&) = delete;
+
+		inline ~TraceZone() {
+			TraceEnd(name);
+		}
+	};
+}
+
+#else
+
+#define TRACE_ZONE(name) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#define TRACE_FRAME() do {} while (0)
+#define TRACE_THREAD_NAME(name) do {} while (0)
+#define TRACE_EXPORT(path) do {} while (0)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace core {
+	// Bounded Chase-Lev work-stealing deque (with the memory orderings of Le et al., "Correct
+	// and Efficient Work-Stealing for Weak Memory Models"). The owning thread pushes and pops at
+	// the bottom like a stack, any other thread steals the oldest item from the top. Only a
+	// steal racing the owner for the last item costs a CAS.
+	template<typename T, size_t Capacity>
+	class WorkStealingDeque {
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+	protected:
+		std::atomic<T> cells[Capacity];
+
+		alignas(64) std::atomic<int64_t> top;		// Next item to steal, advanced by thieves
+		alignas(64) std::atomic<int64_t> bottom;	// Next free cell, written by the owner
+	public:
+		WorkStealingDeque() : top(0), bottom(0) {}
+		WorkStealingDeque(const WorkStealingDeque&) = delete;
+		WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+		// Owner only, returns false when full
+		bool Push(T value) {
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			if (b - t >= static_cast<int64_t>(Capacity)) {
+				return false;
+			}
+
+			cells[b & (Capacity - 1)].store(value, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Owner only, takes the newest item, returns false when empty
+		bool Pop(T& out) {
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b) {
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			out = cells[b & (Capacity - 1)].load(std::memory_order_relaxed);
+			if (t == b) {
+				// Last item, a thief may be taking it at the same time
+				bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
+			return true;
+		}
+
+		// Any thread, takes the oldest item. Returns false when empty or when another thread
+		// took it first.
+		bool Steal(T& out) {
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b) {
+				return false;
+			}
+
+			T value = cells[t & (Capacity - 1)].load(std::memory_order_relaxed);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+				return false;
+			}
+
+			out = value;
+			return true;
+		}
+
+		// Approximate when other threads are pushing or popping
+		inline bool IsEmpty() const {
+			return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+		}
+	};
+}
\ No newline at end of file
@@ -2,34 +2,58 @@
 #include "../fix_vscode.h"
 #include <glad/glad.h>
 #include <vector>
-#include <iostream>
+#include "../core/log.hpp"
+#include "../core/memory_stats.hpp"
 
 namespace gl {
+	inline core::MemoryCategory BufferCategory(GLenum usage) {
+		switch (usage) {
+			case GL_STREAM_DRAW:
+			case GL_STREAM_READ:
+			case GL_STREAM_COPY:
+				return core::MemoryCategory::BufferStream;
+			case GL_DYNAMIC_DRAW:
+			case GL_DYNAMIC_READ:
+			case GL_DYNAMIC_COPY:
+				return core::MemoryCategory::BufferDynamic;
+			default:
+				return core::MemoryCategory::BufferStatic;
+		}
+	}
+
 	template<GLenum slot>
 	class Buffer {
 	protected:
 		GLuint id;
 		GLsizeiptr size;
+		GLenum usage;
 	public:
-		Buffer() : id(0), size(0) {
+		Buffer() : id(0), size(0), usage(GL_STATIC_DRAW) {
 
 		}
 		Buffer(const Buffer& other) = delete;
 		const Buffer& operator=(const Buffer& other) = delete;
 
+		// Creates the buffer from count elements at data, uploaded straight from the caller's memory
 		template<typename T>
-		bool Load(std::vector<T> data, GLenum usage_hint = GL_STATIC_DRAW) {
+		bool Load(const T* data, size_t count, GLenum usage_hint = GL_STATIC_DRAW) {
 			if (id != 0)
 				return false;
 
 			glGenBuffers(1, &id);
 			glBindBuffer(slot, id);
-			size = sizeof(T) * data.size();
-			std::cout << "[GL] Buffer: Generating buffer: " << id << " with size " << size << std::endl;
-			glBufferData(slot, size, &data[0], usage_hint);
+			size = sizeof(T) * count;
+			LOG_DEBUG("GL", "Buffer: Generating buffer: %u with size %lld", id, static_cast<long long>(size));
+			glBufferData(slot, size, data, usage_hint);
+			usage = usage_hint;
+			core::MemoryAllocated(BufferCategory(usage), size);
 			
 			return true;
 		}
+		template<typename T>
+		bool Load(const std::vector<T>& data, GLenum usage_hint = GL_STATIC_DRAW) {
+			return Load(data.data(), data.size(), usage_hint);
+		}
 		bool Allocate(GLsizeiptr size, GLenum usage_hint = GL_STATIC_DRAW) {
 			if (id != 0)
 				return false;
@@ -38,23 +62,53 @@ namespace gl {
 			glBindBuffer(slot, id);
 			this->size = size;
 			glBufferData(slot, size, nullptr, usage_hint);
+			usage = usage_hint;
+			core::MemoryAllocated(BufferCategory(usage), size);
 
 			return true;
 		}
+		// Writes count elements at offset bytes into the buffer
 		template<typename T>
-		bool Update(std::vector<T> data, size_t offset) {
+		bool Update(const T* data, size_t count, size_t offset) {
 			if (id == 0)
 				return false;
 
-			GLsizeiptr sz = sizeof(T) * data.size();
-			if (sz + offset > size) {
+			GLsizeiptr sz = sizeof(T) * count;
+			if (sz + static_cast<GLsizeiptr>(offset) > size) {
 				return false;
 			}
 
 			glBindBuffer(slot, id);
-			glBufferSubData(slot, offset, sz, &data[0]);
+			glBufferSubData(slot, offset, sz, data);
+			return true;
+		}
+		template<typename T>
+		bool Update(const std::vector<T>& data, size_t offset) {
+			return Update(data.data(), data.size(), offset);
+		}
+		// Replaces the whole content of a GL_STREAM_DRAW buffer. The old storage is orphaned
+		// first, so the upload never waits for draws still reading last frame's data.
+		bool Stream(const void* data, GLsizeiptr size) {
+			if (id == 0)
+				return false;
+
+			glBindBuffer(slot, id);
+			if (size > this->size || usage != GL_STREAM_DRAW) {
+				core::MemoryFreed(BufferCategory(usage), this->size);
+				this->size = size > this->size ? size : this->size;
+				usage = GL_STREAM_DRAW;
+				core::MemoryAllocated(BufferCategory(usage), this->size);
+			}
+			glBufferData(slot, this->size, nullptr, GL_STREAM_DRAW);
+			if (size > 0) {
+				glBufferSubData(slot, 0, size, data);
+			}
+			return true;
 		}
 
+		inline GLuint Id() const { return id; }
+		inline GLsizeiptr Size() const { return size; }
+
 		bool Bind() {
 			if (id == 0)
 				return false;
@@ -65,8 +119,9 @@ namespace gl {
 
 		~Buffer() {
 			if (id != 0) {
-				std::cout << "[GL] Buffer: deleting buffer " << id << std::endl;
+				LOG_DEBUG("GL", "Buffer: deleting buffer %u", id);
 				glDeleteBuffers(1, &id);
+				core::MemoryFreed(BufferCategory(usage), size);
 			}
 		}
 	};
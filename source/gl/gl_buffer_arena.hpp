@@ -0,0 +1,95 @@
+#pragma once
+#include "../fix_vscode.h"
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "gl_buffer.hpp"
+#include "../core/log.hpp"
+
+namespace gl {
+	// A sub-allocation of a BufferArena: offset bytes into the arena's page-th buffer
+	struct BufferRange {
+		uint32_t page;
+		GLintptr offset;
+		GLsizeiptr size;
+
+		inline bool IsValid() const { return size > 0; }
+	};
+
+	// Packs many small, long-lived meshes into a few large GL buffers ("pages"). Ranges are
+	// bump-allocated and never freed individually, the pages live as long as the arena.
+	// Draws bind the page once and select their data with attribute/index offsets and a
+	// base vertex, instead of owning a GL buffer per attribute.
+	template<GLenum slot>
+	class BufferArena {
+	protected:
+		std::vector<std::unique_ptr<Buffer<slot>>> pages;
+		std::vector<GLsizeiptr> pageUsed;
+		GLsizeiptr pageSize;
+
+		// alignment does not need to be a power of two, so vertex ranges can be aligned to
+		// their stride and addressed with a base vertex
+		static inline GLintptr AlignUp(GLintptr offset, GLsizeiptr alignment) {
+			return ((offset + alignment - 1) / alignment) * alignment;
+		}
+	public:
+		explicit BufferArena(GLsizeiptr pageSize) : pageSize(pageSize) {}
+		BufferArena(const BufferArena&) = delete;
+		BufferArena& operator=(const BufferArena&) = delete;
+
+		// Returns an invalid range when the GL buffer for a new page cannot be created
+		BufferRange Allocate(GLsizeiptr size, GLsizeiptr alignment = 4) {
+			if (size <= 0 || alignment <= 0) {
+				return BufferRange { 0, 0, 0 };
+			}
+
+			for (uint32_t i = 0; i < pages.size(); i++) {
+				GLintptr offset = AlignUp(pageUsed[i], alignment);
+				if (offset + size <= pages[i]->Size()) {
+					pageUsed[i] = offset + size;
+					return BufferRange { i, offset, size };
+				}
+			}
+
+			// Oversized ranges get a page of their own
+			GLsizeiptr newPageSize = size > pageSize ? size : pageSize;
+			auto page = std::make_unique<Buffer<slot>>();
+			if (!page->Allocate(newPageSize, GL_STATIC_DRAW)) {
+				return BufferRange { 0, 0, 0 };
+			}
+			LOG_DEBUG("GL", "BufferArena: new page %u of %lld bytes", page->Id(), static_cast<long long>(newPageSize));
+
+			pages.push_back(std::move(page));
+			pageUsed.push_back(size);
+			return BufferRange { static_cast<uint32_t>(pages.size() - 1), 0, size };
+		}
+
+		// Allocates a range for count elements, aligned to the element size, and fills it
+		template<typename T>
+		BufferRange Upload(const T* data, size_t count, GLsizeiptr alignment = sizeof(T)) {
+			BufferRange range = Allocate(sizeof(T) * count, alignment);
+			if (range.IsValid() && !pages[range.page]->Update(data, count, range.offset)) {
+				return BufferRange { 0, 0, 0 };
+			}
+			return range;
+		}
+
+		// Overwrites part of an existing range, offset is relative to the range
+		template<typename T>
+		bool Update(const BufferRange& range, const T* data, size_t count, GLintptr offset = 0) {
+			if (!range.IsValid() || range.page >= pages.size() || offset + static_cast<GLsizeiptr>(sizeof(T) * count) > range.size) {
+				return false;
+			}
+			return pages[range.page]->Update(data, count, range.offset + offset);
+		}
+
+		inline Buffer<slot>* Page(uint32_t page) const {
+			return page < pages.size() ? pages[page].get() : nullptr;
+		}
+		inline Buffer<slot>* Page(const BufferRange& range) const {
+			return range.IsValid() ? Page(range.page) : nullptr;
+		}
+		inline size_t PageCount() const { return pages.size(); }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "gl_framebuffer.hpp"
+#include "../core/log.hpp"
+#include "../core/memory_stats.hpp"
+
+namespace gl {
+	FramebufferBinding FramebufferBinding::Current() {
+		FramebufferBinding binding;
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &binding.framebuffer);
+		glGetIntegerv(GL_VIEWPORT, binding.viewport);
+		return binding;
+	}
+
+	void FramebufferBinding::Restore() const {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	}
+
+	Framebuffer::Framebuffer() : id(0), depth(0), size(0, 0) {
+
+	}
+
+	bool Framebuffer::Allocate(glm::ivec2 size) {
+		if (id != 0 && size == this->size) {
+			return true;
+		}
+		Destroy();
+
+		color = std::make_unique<Texture>();
+		if (!color->AllocateRGBA(size)) {
+			color = nullptr;
+			return false;
+		}
+
+		// The layer is redrawn as a whole and sampled 1:1, mipmaps would only go stale
+		glBindTexture(GL_TEXTURE_2D, color->Id());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glGenRenderbuffers(1, &depth);
+		glBindRenderbuffer(GL_RENDERBUFFER, depth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+
+		glGenFramebuffers(1, &id);
+		glBindFramebuffer(GL_FRAMEBUFFER, id);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color->Id(), 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			LOG_ERROR("GL", "Framebuffer: incomplete framebuffer, status 0x%x", status);
+			Destroy();
+			return false;
+		}
+
+		this->size = size;
+		core::MemoryAllocated(core::MemoryCategory::Renderbuffer, static_cast<uint64_t>(size.x) * size.y * 4);
+		LOG_INFO("GL", "Allocated framebuffer %u with size %dx%d", id, size.x, size.y);
+		return true;
+	}
+
+	bool Framebuffer::Bind() {
+		if (id == 0)
+			return false;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, id);
+		glViewport(0, 0, size.x, size.y);
+		return true;
+	}
+
+	bool Framebuffer::Bind(glm::ivec2 viewportSize) {
+		if (id == 0)
+			return false;
+
+		viewportSize = glm::clamp(viewportSize, glm::ivec2(1), size);
+		glBindFramebuffer(GL_FRAMEBUFFER, id);
+		glViewport(0, 0, viewportSize.x, viewportSize.y);
+		return true;
+	}
+
+	void Framebuffer::BlitToDefault(glm::ivec2 sourceSize, glm::ivec2 screenSize) const {
+		sourceSize = glm::clamp(sourceSize, glm::ivec2(1), size);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, id);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		// Same size copies are exact, only an actual upscale needs filtering
+		GLenum filter = sourceSize == screenSize ? GL_NEAREST : GL_LINEAR;
+		glBlitFramebuffer(0, 0, sourceSize.x, sourceSize.y, 0, 0, screenSize.x, screenSize.y, GL_COLOR_BUFFER_BIT, filter);
+		BindDefault(screenSize);
+	}
+
+	void Framebuffer::BindDefault(glm::ivec2 screenSize) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, screenSize.x, screenSize.y);
+	}
+
+	void Framebuffer::Destroy() {
+		if (id != 0 && size.x > 0) {
+			core::MemoryFreed(core::MemoryCategory::Renderbuffer, static_cast<uint64_t>(size.x) * size.y * 4);
+		}
+		if (id != 0) {
+			LOG_DEBUG("GL", "Framebuffer: deleting framebuffer %u", id);
+			glDeleteFramebuffers(1, &id);
+			id = 0;
+		}
+		if (depth != 0) {
+			glDeleteRenderbuffers(1, &depth);
+			depth = 0;
+		}
+		color = nullptr;
+		size = glm::ivec2(0, 0);
+	}
+
+	Framebuffer::~Framebuffer() {
+		Destroy();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "../fix_vscode.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include "gl_texture.hpp"
+
+namespace gl {
+	// Draw framebuffer and viewport in use, saved by code that renders offscreen in the middle
+	// of a frame so it can hand the target back to whoever was drawing before
+	struct FramebufferBinding {
+		GLint framebuffer;
+		GLint viewport[4];
+
+		static FramebufferBinding Current();
+		void Restore() const;
+	};
+
+	// Offscreen render target: an RGBA color texture plus a depth renderbuffer
+	class Framebuffer {
+	protected:
+		GLuint id;
+		GLuint depth;
+		std::unique_ptr<Texture> color;
+		glm::ivec2 size;
+
+		void Destroy();
+	public:
+		Framebuffer();
+		Framebuffer(const Framebuffer&) = delete;
+		Framebuffer& operator=(const Framebuffer&) = delete;
+
+		// (Re)creates the attachments with the given size, keeps them when the size is unchanged.
+		// Returns false when the framebuffer is not complete.
+		bool Allocate(glm::ivec2 size);
+
+		// Binds the framebuffer for drawing and sets the viewport to cover it
+		bool Bind();
+		// Binds the framebuffer for drawing into its bottom-left viewportSize pixels only,
+		// used to render at a reduced resolution without reallocating the attachments
+		bool Bind(glm::ivec2 viewportSize);
+		static void BindDefault(glm::ivec2 screenSize);
+
+		// Stretches the bottom-left sourceSize pixels of the color attachment over the whole
+		// default framebuffer with linear filtering, then leaves the default framebuffer bound
+		void BlitToDefault(glm::ivec2 sourceSize, glm::ivec2 screenSize) const;
+
+		inline bool IsValid() const { return id != 0; }
+		inline glm::ivec2 Size() const { return size; }
+		// Color attachment, sampled with linear filtering and no mipmaps
+		inline const Texture* Color() const { return color.get(); }
+
+		~Framebuffer();
+	};
+}
\ No newline at end of file
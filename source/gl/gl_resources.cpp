@@ -0,0 +1,82 @@
+#include "gl_resources.hpp"
+#include "../core/log.hpp"
+
+namespace gl {
+	Resources::Resources() : textures(64), vertexBuffers(64), indexBuffers(32), shaders(8), framebuffers(4), staticVertices(256 * 1024), staticIndices(64 * 1024), tileQuad {} {
+
+	}
+
+	TextureHandle Resources::LoadPNG(const uint8_t* png_data, const size_t png_data_size) {
+		TextureHandle handle = textures.Create();
+		Texture* texture = textures.Get(handle);
+		if (texture == nullptr) {
+			LOG_ERROR("GL", "Resources: texture pool is full");
+			return TextureHandle();
+		}
+
+		if (!texture->LoadPNG(png_data, png_data_size, pngDecoder)) {
+			textures.Release(handle);
+			return TextureHandle();
+		}
+
+		return handle;
+	}
+
+	bool Resources::LoadTileAssets() {
+		if (tileShader.IsValid()) {
+			return true;
+		}
+
+		static const TileVertex vertices[] = {
+			{ -0.5f, -0.5f, 0.0f, 0.0f, 1.0f },
+			{ 0.5f, -0.5f, 0.0f, 1.0f, 1.0f },
+			{ 0.5f, 0.5f, 0.0f, 1.0f, 0.0f },
+			{ -0.5f, 0.5f, 0.0f, 0.0f, 0.0f }
+		};
+		static const unsigned short indices[] = {
+			0, 1, 2,
+			0, 2, 3
+		};
+
+		if (!tileQuad.vertices.IsValid()) {
+			tileQuad.vertices = staticVertices.Upload(vertices, 4);
+		}
+		if (!tileQuad.indices.IsValid()) {
+			tileQuad.indices = staticIndices.Upload(indices, 6);
+		}
+		tileQuad.amount = 6;
+
+		ShaderHandle handle = shaders.Create();
+		TileShader* shader = shaders.Get(handle);
+		if (!tileQuad.vertices.IsValid() || !tileQuad.indices.IsValid() || shader == nullptr || !shader->Load()) {
+			LOG_ERROR("GL", "Resources: failed to load the tile shader and quad");
+			shaders.Release(handle);
+			return false;
+		}
+
+		tileShader = handle;
+		return true;
+	}
+
+	TileMesh TileData::Resolve(const Resources& resources) const {
+		return TileMesh {
+			resources.staticVertices.Page(vertices),
+			resources.staticIndices.Page(indices),
+			static_cast<GLint>(vertices.offset / static_cast<GLintptr>(sizeof(TileVertex))),
+			indices.offset,
+			amount
+		};
+	}
+
+	void Resources::EndFrame() {
+		textures.Collect();
+		vertexBuffers.Collect();
+		indexBuffers.Collect();
+		shaders.Collect();
+		framebuffers.Collect();
+	}
+
+	Resources::~Resources() {
+		EndFrame();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#pragma once
+#include "../fix_vscode.h"
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include "gl_buffer.hpp"
+#include "gl_buffer_arena.hpp"
+#include "gl_texture.hpp"
+#include "gl_framebuffer.hpp"
+#include "tile_shader.hpp"
+
+namespace gl {
+	// Compact generational reference to a resource stored in a ResourcePool.
+	// The low bits index the pool slot, the high bits hold the slot generation at the time the
+	// handle was created, so a handle to a destroyed (and possibly reused) slot is detected by
+	// a single compare. A value of 0 is never handed out and means "no resource".
+	template<typename T>
+	struct Handle {
+		static constexpr uint32_t IndexBits = 20;
+		static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+		static constexpr uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+		uint32_t value;
+
+		constexpr Handle() : value(0) {}
+		constexpr Handle(uint32_t index, uint32_t generation) : value((generation << IndexBits) | (index & IndexMask)) {}
+
+		constexpr uint32_t Index() const { return value & IndexMask; }
+		constexpr uint32_t Generation() const { return value >> IndexBits; }
+		constexpr bool IsValid() const { return value != 0; }
+
+		constexpr bool operator==(const Handle& other) const { return value == other.value; }
+		constexpr bool operator!=(const Handle& other) const { return value != other.value; }
+	};
+
+	// Fixed-capacity, contiguous storage for resources of type T addressed through Handle<T>.
+	// Destruction is deferred: Release() invalidates the handle immediately, but the resource
+	// itself (and its GL object) is only destroyed by the next Collect(), at a frame boundary.
+	template<typename T>
+	class ResourcePool {
+	protected:
+		struct Slot {
+			T value;
+			uint32_t generation;
+			bool alive;
+
+			Slot() : generation(1), alive(false) {}
+		};
+
+		std::unique_ptr<Slot[]> slots;
+		uint32_t capacity;
+		uint32_t used;
+		std::vector<uint32_t> freeList;
+		std::vector<uint32_t> pendingDestroy;
+
+		inline Slot* Resolve(Handle<T> handle) const {
+			uint32_t index = handle.Index();
+			if (index >= used) {
+				return nullptr;
+			}
+
+			Slot* slot = &slots[index];
+			if (!slot->alive || slot->generation != handle.Generation()) {
+				return nullptr;
+			}
+
+			return slot;
+		}
+	public:
+		explicit ResourcePool(uint32_t capacity) : slots(new Slot[capacity]), capacity(capacity), used(0) {
+			freeList.reserve(capacity);
+			pendingDestroy.reserve(capacity);
+		}
+		ResourcePool(const ResourcePool&) = delete;
+		ResourcePool& operator=(const ResourcePool&) = delete;
+
+		// Returns an invalid handle when the pool is full
+		Handle<T> Create() {
+			uint32_t index;
+			if (!freeList.empty()) {
+				index = freeList.back();
+				freeList.pop_back();
+			} else if (used < capacity) {
+				index = used++;
+			} else {
+				return Handle<T>();
+			}
+
+			Slot& slot = slots[index];
+			slot.alive = true;
+			return Handle<T>(index, slot.generation);
+		}
+
+		inline T* Get(Handle<T> handle) const {
+			Slot* slot = Resolve(handle);
+			return slot != nullptr ? &slot->value : nullptr;
+		}
+
+		inline bool IsAlive(Handle<T> handle) const {
+			return Resolve(handle) != nullptr;
+		}
+
+		bool Release(Handle<T> handle) {
+			Slot* slot = Resolve(handle);
+			if (slot == nullptr) {
+				return false;
+			}
+
+			slot->alive = false;
+			slot->generation = (slot->generation + 1) & Handle<T>::GenerationMask;
+			if (slot->generation == 0) {
+				slot->generation = 1;
+			}
+			pendingDestroy.push_back(handle.Index());
+			return true;
+		}
+
+		// Destroys every resource released since the last call and recycles its slot
+		void Collect() {
+			for (uint32_t index : pendingDestroy) {
+				Slot& slot = slots[index];
+				slot.value.~T();
+				new (&slot.value) T();
+				freeList.push_back(index);
+			}
+			pendingDestroy.clear();
+		}
+
+		inline uint32_t Capacity() const { return capacity; }
+		inline uint32_t Count() const { return used - static_cast<uint32_t>(freeList.size() + pendingDestroy.size()); }
+	};
+
+	typedef Handle<Texture> TextureHandle;
+	typedef Handle<Buffer<GL_ARRAY_BUFFER>> VertexBufferHandle;
+	typedef Handle<Buffer<GL_ELEMENT_ARRAY_BUFFER>> IndexBufferHandle;
+	typedef Handle<TileShader> ShaderHandle;
+	typedef Handle<Framebuffer> FramebufferHandle;
+
+	class Resources;
+
+	// Ranges of a mesh inside the static arenas of Resources
+	class TileData {
+	public:
+		BufferRange vertices;
+		BufferRange indices;
+		GLint amount;
+
+		// Resolves the ranges against the arenas, the result is not owned by TileData
+		TileMesh Resolve(const Resources& resources) const;
+	};
+
+	// Owner of every GPU resource of the application. Hot paths pass handles around and resolve
+	// them here, instead of sharing ownership of the resources themselves.
+	class Resources {
+	public:
+		ResourcePool<Texture> textures;
+		ResourcePool<Buffer<GL_ARRAY_BUFFER>> vertexBuffers;
+		ResourcePool<Buffer<GL_ELEMENT_ARRAY_BUFFER>> indexBuffers;
+		ResourcePool<TileShader> shaders;
+		ResourcePool<Framebuffer> framebuffers;
+		// Shared storage for static meshes
+		BufferArena<GL_ARRAY_BUFFER> staticVertices;
+		BufferArena<GL_ELEMENT_ARRAY_BUFFER> staticIndices;
+		// Shared by every texture load
+		PngDecoder pngDecoder;
+		// Tile shader (all of its permutations) and tile quad shared by every tile renderer,
+		// valid once LoadTileAssets() succeeded
+		ShaderHandle tileShader;
+		TileData tileQuad;
+
+		Resources();
+		Resources(const Resources&) = delete;
+		Resources& operator=(const Resources&) = delete;
+
+		TextureHandle LoadPNG(const uint8_t* png_data, const size_t png_data_size);
+		// Compiles the tile shader and uploads the tile quad on the first successful call,
+		// later calls return at once
+		bool LoadTileAssets();
+
+		// Call once per frame, after presenting, to destroy released resources
+		void EndFrame();
+
+		~Resources();
+	};
+}
\ No newline at end of file
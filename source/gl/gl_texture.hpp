@@ -2,20 +2,33 @@
 #include "../fix_vscode.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include "../core/memory_stats.hpp"
+#include "png_decoder.hpp"
 
 namespace gl {
+	// GPU memory of a size texture with bytesPerPixel, including the whole mip chain when mipmapped
+	size_t TextureBytes(glm::ivec2 size, size_t bytesPerPixel, bool mipmapped);
+
 	class Texture {
 	protected:
 		GLuint id;
 		glm::ivec2 size;
+		core::MemoryCategory category;
+		size_t bytes;
+
+		void Account(core::MemoryCategory category, size_t bytes);
 	public:
 		Texture();
 
-		bool LoadPNG(const uint8_t* png_data, const size_t png_data_size);
+		// Decodes with decoder, whose scratch memory is reused by the next load
+		bool LoadPNG(const uint8_t* png_data, const size_t png_data_size, PngDecoder& decoder);
 		bool AllocateRGBA(glm::ivec2 size);
+		// Single channel texture sampled with nearest filtering, for masks and glyph atlases
+		bool LoadR8(glm::ivec2 size, const uint8_t* pixels);
 
 		inline GLuint Id() const { return id; }
 		inline glm::ivec2 Size() const { return size; }
+		inline size_t Bytes() const { return bytes; }
 
 		~Texture();
 	};
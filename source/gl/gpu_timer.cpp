@@ -0,0 +1,67 @@
+#include "gpu_timer.hpp"
+
+namespace gl {
+	GpuTimer::GpuTimer() : next(0), active(false), hasResult(false), lastMs(0.0) {
+		glGenQueries(QueryCount, queries);
+		for (unsigned int i = 0; i < QueryCount; i++) {
+			pending[i] = false;
+		}
+	}
+
+	void GpuTimer::Begin() {
+		if (pending[next]) {
+			Poll();
+		}
+		// The GPU is more than QueryCount frames behind, skip this measurement
+		if (pending[next]) {
+			return;
+		}
+
+		glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+		active = true;
+	}
+
+	void GpuTimer::End() {
+		if (!active) {
+			return;
+		}
+
+		glEndQuery(GL_TIME_ELAPSED);
+		pending[next] = true;
+		next = (next + 1) % QueryCount;
+		active = false;
+	}
+
+	bool GpuTimer::Poll() {
+		bool updated = false;
+		// Oldest query first, results become available in submission order
+		for (unsigned int i = 0; i < QueryCount; i++) {
+			unsigned int index = (next + i) % QueryCount;
+			if (!pending[index]) {
+				continue;
+			}
+
+			GLuint available = 0;
+			glGetQueryObjectuiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				break;
+			}
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &elapsed);
+			pending[index] = false;
+			lastMs = elapsed / 1000000.0;
+			hasResult = true;
+			updated = true;
+		}
+
+		return updated;
+	}
+
+	GpuTimer::~GpuTimer() {
+		if (active) {
+			glEndQuery(GL_TIME_ELAPSED);
+		}
+		glDeleteQueries(QueryCount, queries);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "../fix_vscode.h"
+#include <glad/glad.h>
+
+namespace gl {
+	// Measures GPU time of a section of the frame with GL_TIME_ELAPSED queries.
+	// Queries are kept in a small ring and their results are collected a few frames later, once
+	// the GPU has reached them, so measuring never stalls the CPU waiting for the GPU. A frame
+	// whose ring slot is still in flight is simply not measured.
+	class GpuTimer {
+	public:
+		static constexpr unsigned int QueryCount = 4;
+	protected:
+		GLuint queries[QueryCount];
+		bool pending[QueryCount];
+		unsigned int next;
+		bool active;
+		bool hasResult;
+		double lastMs;
+	public:
+		GpuTimer();
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+
+		// Starts timing the GPU commands issued until End(). Only one timer can be active at a time.
+		void Begin();
+		void End();
+
+		// Collects the results that are available without waiting.
+		// Returns true when at least one new measurement arrived.
+		bool Poll();
+
+		inline bool HasResult() const { return hasResult; }
+		// Most recent measurement, in milliseconds
+		inline double LastMs() const { return lastMs; }
+
+		~GpuTimer();
+	};
+}
\ No newline at end of file
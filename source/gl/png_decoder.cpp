@@ -0,0 +1,198 @@
+#include "png_decoder.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <png.h>
+#include "../core/log.hpp"
+#include "../core/memory_stats.hpp"
+#include "../core/trace.hpp"
+
+namespace gl {
+	namespace {
+		struct ReadInfo {
+			const uint8_t* buff;
+			const size_t buff_size;
+			const uint8_t* ptr;
+
+			size_t Read(void* target, size_t size) {
+				if (static_cast<size_t>((ptr + size) - buff) > buff_size) {
+					size = (buff_size + buff) - ptr;
+				}
+
+				if (size == 0) {
+					return 0;
+				}
+
+				std::memcpy(target, ptr, size);
+				ptr += size;
+
+				return size;
+			}
+		};
+
+		void PNGReadData(png_structp png, png_bytep out_bytes, png_size_t byte_count) {
+			png_voidp io_ptr = png_get_io_ptr(png);
+			if (io_ptr == NULL) {
+				png_error(png, "Missing read state");
+			}
+
+			ReadInfo* info = static_cast<ReadInfo*>(io_ptr);
+			if (info->Read(out_bytes, byte_count) != byte_count) {
+				png_error(png, "Truncated PNG data");
+			}
+		}
+
+		png_voidp PNGAllocate(png_structp png, png_alloc_size_t size) {
+			return static_cast<DecodeArena*>(png_get_mem_ptr(png))->Allocate(size);
+		}
+
+		void PNGFree(png_structp png, png_voidp pointer) {
+			static_cast<DecodeArena*>(png_get_mem_ptr(png))->Free(pointer);
+		}
+
+		void PNGError(png_structp png, png_const_charp message) {
+			LOG_ERROR("PNG", "%s", message);
+			// libpng errors must not return, built without exceptions the only way out is the
+			// jump buffer set by Decode()
+			png_longjmp(png, 1);
+		}
+
+		void PNGWarning(png_structp png, png_const_charp message) {
+			LOG_WARN("PNG", "%s", message);
+		}
+	}
+
+	DecodeArena::DecodeArena(size_t capacity) : block(new uint8_t[capacity]), capacity(capacity), used(0), peak(0), overflowAllocations(0) {
+
+	}
+
+	void* DecodeArena::Allocate(size_t bytes) {
+		size_t start = (used + Alignment - 1) & ~(Alignment - 1);
+		used = start + bytes;
+		if (used > peak) {
+			peak = used;
+		}
+
+		if (used <= capacity) {
+			return block.get() + start;
+		}
+
+		overflowAllocations++;
+		return std::malloc(bytes);
+	}
+
+	void DecodeArena::Free(void* pointer) {
+		uint8_t* p = static_cast<uint8_t*>(pointer);
+		if (p != nullptr && (p < block.get() || p >= block.get() + capacity)) {
+			std::free(pointer);
+		}
+	}
+
+	void DecodeArena::Reset() {
+		if (peak > capacity) {
+			LOG_DEBUG("PNG", "DecodeArena: growing from %zu to %zu bytes", capacity, peak);
+			capacity = peak;
+			block.reset(new uint8_t[capacity]);
+		}
+		used = 0;
+		peak = 0;
+	}
+
+	PngDecoder::PngDecoder(size_t arenaCapacity) : arena(arenaCapacity), accounted(0) {
+		Account();
+	}
+
+	void PngDecoder::Account() {
+		size_t bytes = arena.Capacity() + image.capacity();
+		if (bytes != accounted) {
+			// The scratch counts as one live allocation while it holds any memory
+			if (accounted > 0) {
+				core::MemoryFreed(core::MemoryCategory::DecodeScratch, accounted);
+			}
+			if (bytes > 0) {
+				core::MemoryAllocated(core::MemoryCategory::DecodeScratch, bytes);
+			}
+			accounted = bytes;
+		}
+	}
+
+	bool PngDecoder::Decode(const uint8_t* data, size_t dataSize, DecodedImage& out) {
+		TRACE_ZONE("PngDecoder::Decode");
+		if (dataSize < 8 || png_sig_cmp(data, 0, 8) != 0) {
+			LOG_ERROR("PNG", "Not a PNG file.");
+			return false;
+		}
+
+		png_structp png = png_create_read_struct_2(PNG_LIBPNG_VER_STRING, nullptr, PNGError, PNGWarning, &arena, PNGAllocate, PNGFree);
+		if (png == nullptr) {
+			LOG_ERROR("PNG", "Failed to initialize PNG.");
+			arena.Reset();
+			return false;
+		}
+
+		png_infop info = png_create_info_struct(png);
+		if (info == nullptr) {
+			LOG_ERROR("PNG", "Failed to create PNG info.");
+			png_destroy_read_struct(&png, nullptr, nullptr);
+			arena.Reset();
+			return false;
+		}
+
+		ReadInfo readInfo { data, dataSize, data + 8 };
+
+		// Nothing with a destructor may be created between here and the last libpng call
+		if (setjmp(png_jmpbuf(png))) {
+			png_destroy_read_struct(&png, &info, nullptr);
+			arena.Reset();
+			return false;
+		}
+
+		png_set_read_fn(png, &readInfo, PNGReadData);
+		png_set_sig_bytes(png, 8);
+		png_read_info(png, info);
+
+		png_uint_32 width = png_get_image_width(png, info);
+		png_uint_32 height = png_get_image_height(png, info);
+
+		// Whatever the source format, rows come out as 8-bit RGBA
+		png_set_strip_16(png);
+		png_set_palette_to_rgb(png);
+		png_set_expand_gray_1_2_4_to_8(png);
+		png_set_tRNS_to_alpha(png);
+		png_set_gray_to_rgb(png);
+		png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+		int passes = png_set_interlace_handling(png);
+		png_read_update_info(png, info);
+
+		size_t rowBytes = png_get_rowbytes(png, info);
+		if (rowBytes != static_cast<size_t>(width) * 4) {
+			png_error(png, "Unexpected row size after conversion to RGBA");
+		}
+
+		size_t imageBytes = rowBytes * height;
+		if (image.size() < imageBytes) {
+			image.resize(imageBytes);
+			Account();
+		}
+
+		for (int pass = 0; pass < passes; pass++) {
+			for (png_uint_32 row = 0; row < height; row++) {
+				png_read_row(png, image.data() + row * rowBytes, nullptr);
+			}
+		}
+
+		png_destroy_read_struct(&png, &info, nullptr);
+		arena.Reset();
+		Account();
+
+		out.width = width;
+		out.height = height;
+		out.pixels = image.data();
+		return true;
+	}
+
+	PngDecoder::~PngDecoder() {
+		if (accounted > 0) {
+			core::MemoryFreed(core::MemoryCategory::DecodeScratch, accounted);
+		}
+	}
+}
\ No newline at end of file
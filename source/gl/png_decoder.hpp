@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gl {
+	// Bump allocator backing libpng's internal allocations for one image at a time.
+	// Frees are no-ops, the whole arena is recycled by Reset() once the image is done.
+	// Requests that do not fit are served by the heap, and the arena grows to the peak usage
+	// on the next Reset(), so after the first few images decoding causes no heap traffic.
+	class DecodeArena {
+	public:
+		static constexpr size_t Alignment = 16;
+	protected:
+		std::unique_ptr<uint8_t[]> block;
+		size_t capacity;
+		size_t used;
+		size_t peak;
+		size_t overflowAllocations;
+	public:
+		explicit DecodeArena(size_t capacity);
+		DecodeArena(const DecodeArena&) = delete;
+		DecodeArena& operator=(const DecodeArena&) = delete;
+
+		void* Allocate(size_t bytes);
+		void Free(void* pointer);
+		// Every allocation must have been freed
+		void Reset();
+
+		inline size_t Capacity() const { return capacity; }
+		// Heap fallbacks since the start, 0 once the arena is warm
+		inline size_t OverflowAllocations() const { return overflowAllocations; }
+	};
+
+	// A decoded image, always 8-bit RGBA. The pixels belong to the decoder and stay valid until
+	// its next Decode().
+	struct DecodedImage {
+		uint32_t width;
+		uint32_t height;
+		const uint8_t* pixels;
+	};
+
+	// Reusable PNG decoding context. libpng allocates from a DecodeArena through
+	// png_create_read_struct_2, and the decoded image is written into a scratch buffer that is
+	// kept (and only grows) across images. Every format is converted to 8-bit RGBA by libpng
+	// transforms, straight into the image rows, so there is no per-row conversion buffer.
+	// Not thread safe, use one decoder per loading thread.
+	class PngDecoder {
+	protected:
+		DecodeArena arena;
+		std::vector<uint8_t> image;
+		// DecodeScratch bytes currently reported to memory_stats
+		size_t accounted;
+
+		void Account();
+	public:
+		explicit PngDecoder(size_t arenaCapacity = 64 * 1024);
+		PngDecoder(const PngDecoder&) = delete;
+		PngDecoder& operator=(const PngDecoder&) = delete;
+
+		bool Decode(const uint8_t* data, size_t dataSize, DecodedImage& out);
+
+		inline const DecodeArena& Arena() const { return arena; }
+
+		~PngDecoder();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,390 @@
+#include "text_renderer.hpp"
+#include "../core/log.hpp"
+#include "../core/trace.hpp"
+#include "text_vs.h"
+#include "text_fs.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace gl {
+	namespace {
+		constexpr unsigned int FirstCharacter = 32;
+		constexpr unsigned int CharacterCount = 95;
+		constexpr unsigned int AtlasColumns = 16;
+		constexpr glm::ivec2 AtlasSize(128, 64);
+
+		// Public domain 8x8 font (font8x8_basic, printable ASCII). One byte per row, top row
+		// first, the least significant bit is the leftmost pixel.
+		const uint8_t font8x8[CharacterCount][8] = {
+			{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// space
+			{ 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 },	// !
+			{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// "
+			{ 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 },	// #
+			{ 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 },	// $
+			{ 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 },	// %
+			{ 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 },	// &
+			{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },	// '
+			{ 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 },	// (
+			{ 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 },	// )
+			{ 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 },	// *
+			{ 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 },	// +
+			{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 },	// ,
+			{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 },	// -
+			{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 },	// .
+			{ 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 },	// /
+			{ 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 },	// 0
+			{ 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 },	// 1
+			{ 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 },	// 2
+			{ 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 },	// 3
+			{ 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 },	// 4
+			{ 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 },	// 5
+			{ 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 },	// 6
+			{ 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 },	// 7
+			{ 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 },	// 8
+			{ 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 },	// 9
+			{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 },	// :
+			{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 },	// ;
+			{ 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 },	// <
+			{ 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 },	// =
+			{ 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 },	// >
+			{ 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 },	// ?
+			{ 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 },	// @
+			{ 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 },	// A
+			{ 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 },	// B
+			{ 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 },	// C
+			{ 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 },	// D
+			{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 },	// E
+			{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 },	// F
+			{ 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 },	// G
+			{ 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 },	// H
+			{ 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// I
+			{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 },	// J
+			{ 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 },	// K
+			{ 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 },	// L
+			{ 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 },	// M
+			{ 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 },	// N
+			{ 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 },	// O
+			{ 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 },	// P
+			{ 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 },	// Q
+			{ 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 },	// R
+			{ 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 },	// S
+			{ 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// T
+			{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 },	// U
+			{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },	// V
+			{ 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 },	// W
+			{ 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 },	// X
+			{ 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 },	// Y
+			{ 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 },	// Z
+			{ 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 },	// [
+			{ 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 },	// backslash
+			{ 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 },	// ]
+			{ 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },	// ^
+			{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF },	// _
+			{ 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },	// `
+			{ 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 },	// a
+			{ 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 },	// b
+			{ 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 },	// c
+			{ 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 },	// d
+			{ 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 },	// e
+			{ 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 },	// f
+			{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F },	// g
+			{ 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 },	// h
+			{ 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// i
+			{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E },	// j
+			{ 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 },	// k
+			{ 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },	// l
+			{ 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 },	// m
+			{ 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 },	// n
+			{ 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 },	// o
+			{ 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F },	// p
+			{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 },	// q
+			{ 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 },	// r
+			{ 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 },	// s
+			{ 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 },	// t
+			{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 },	// u
+			{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },	// v
+			{ 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 },	// w
+			{ 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 },	// x
+			{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F },	// y
+			{ 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 },	// z
+			{ 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 },	// {
+			{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },	// |
+			{ 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 },	// }
+			{ 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	// ~
+		};
+
+		uint32_t HashText(const char* text, float scale) {
+			uint32_t hash = 2166136261u;
+			for (const char* c = text; *c != '\0'; c++) {
+				hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619u;
+			}
+
+			uint32_t scaleBits;
+			std::memcpy(&scaleBits, &scale, sizeof(scaleBits));
+			return (hash ^ scaleBits) * 16777619u;
+		}
+
+		uint32_t PackColor(glm::vec4 color) {
+			glm::vec4 c = glm::clamp(color, glm::vec4(0.0f), glm::vec4(1.0f));
+			return static_cast<uint32_t>(c.r * 255.0f + 0.5f) |
+				(static_cast<uint32_t>(c.g * 255.0f + 0.5f) << 8) |
+				(static_cast<uint32_t>(c.b * 255.0f + 0.5f) << 16) |
+				(static_cast<uint32_t>(c.a * 255.0f + 0.5f) << 24);
+		}
+	}
+
+	TextRenderer::TextRenderer(Resources& resources) : resources(&resources), indices { 0, 0, 0 }, program(0), vao(0), uProjectionLoc(-1), uAtlasLoc(-1),
+		uploadedGlyphs(0), layoutsChanged(false), frame(0) {
+		layouts.reserve(LayoutCacheSize);
+		vertexData.reserve(MaxGlyphs * 4);
+
+		atlas = resources.textures.Create();
+		vertices = resources.vertexBuffers.Create();
+
+		auto vertexBuffer = resources.vertexBuffers.Get(vertices);
+		if (vertexBuffer == nullptr || !CreateAtlas() || !CreateProgram()) {
+			LOG_ERROR("GL", "TextRenderer: failed to allocate resources");
+			return;
+		}
+
+		// Every glyph is a quad, so the index buffer never changes
+		std::vector<unsigned short> quadIndices(MaxGlyphs * 6);
+		for (unsigned int i = 0; i < MaxGlyphs; i++) {
+			unsigned short base = static_cast<unsigned short>(i * 4);
+			quadIndices[i * 6 + 0] = base;
+			quadIndices[i * 6 + 1] = base + 1;
+			quadIndices[i * 6 + 2] = base + 2;
+			quadIndices[i * 6 + 3] = base;
+			quadIndices[i * 6 + 4] = base + 2;
+			quadIndices[i * 6 + 5] = base + 3;
+		}
+		indices = resources.staticIndices.Upload(quadIndices.data(), quadIndices.size());
+		auto indexBuffer = resources.staticIndices.Page(indices);
+		if (indexBuffer == nullptr) {
+			LOG_ERROR("GL", "TextRenderer: failed to allocate indices");
+			return;
+		}
+
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+
+		vertexBuffer->Allocate(MaxGlyphs * 4 * sizeof(Vertex), GL_STREAM_DRAW);
+		indexBuffer->Bind();
+
+		GLint aPosLoc = glGetAttribLocation(program, "aPos");
+		GLint aUvLoc = glGetAttribLocation(program, "aUv");
+		GLint aColorLoc = glGetAttribLocation(program, "aColor");
+
+		vertexBuffer->Bind();
+		glEnableVertexAttribArray(aPosLoc);
+		glVertexAttribPointer(aPosLoc, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, x)));
+		glEnableVertexAttribArray(aUvLoc);
+		glVertexAttribPointer(aUvLoc, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, u)));
+		glEnableVertexAttribArray(aColorLoc);
+		glVertexAttribPointer(aColorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, color)));
+
+		glBindVertexArray(0);
+	}
+
+	bool TextRenderer::CreateAtlas() {
+		Texture* texture = resources->textures.Get(atlas);
+		if (texture == nullptr) {
+			return false;
+		}
+
+		std::vector<uint8_t> pixels(AtlasSize.x * AtlasSize.y, 0);
+		for (unsigned int c = 0; c < CharacterCount; c++) {
+			unsigned int cellX = (c % AtlasColumns) * GlyphSize;
+			unsigned int cellY = (c / AtlasColumns) * GlyphSize;
+			for (unsigned int row = 0; row < GlyphSize; row++) {
+				for (unsigned int column = 0; column < GlyphSize; column++) {
+					if (font8x8[c][row] & (1u << column)) {
+						pixels[(cellY + row) * AtlasSize.x + cellX + column] = 255;
+					}
+				}
+			}
+		}
+
+		return texture->LoadR8(AtlasSize, pixels.data());
+	}
+
+	bool TextRenderer::CreateProgram() {
+		program = compileShader(reinterpret_cast<const char*>(text_vs), text_vs_size, reinterpret_cast<const char*>(text_fs), text_fs_size);
+		if (program == 0) {
+			LOG_ERROR("GL", "Text shader compilation failed");
+			return false;
+		}
+
+		uProjectionLoc = glGetUniformLocation(program, "uProjection");
+		uAtlasLoc = glGetUniformLocation(program, "uAtlas");
+		return true;
+	}
+
+	void TextRenderer::LayOut(Layout& layout) const {
+		layout.glyphs.clear();
+
+		float advance = GlyphSize * layout.scale;
+		glm::vec2 pen(0.0f, 0.0f);
+		float width = 0.0f;
+		for (char c : layout.text) {
+			if (c == '\n') {
+				pen.x = 0.0f;
+				pen.y += advance;
+				continue;
+			}
+
+			unsigned int character = static_cast<uint8_t>(c);
+			if (character < FirstCharacter || character >= FirstCharacter + CharacterCount) {
+				character = '?';
+			}
+			if (character != ' ') {
+				layout.glyphs.push_back(Glyph { pen, static_cast<uint8_t>(character - FirstCharacter) });
+			}
+
+			pen.x += advance;
+			width = glm::max(width, pen.x);
+		}
+
+		layout.extent = glm::vec2(width, layout.text.empty() ? 0.0f : pen.y + advance);
+	}
+
+	uint32_t TextRenderer::FindLayout(const char* text, float scale) {
+		uint32_t hash = HashText(text, scale);
+		for (uint32_t i = 0; i < layouts.size(); i++) {
+			Layout& layout = layouts[i];
+			if (layout.hash == hash && layout.scale == scale && layout.text == text) {
+				layout.lastUsed = frame;
+				return i;
+			}
+		}
+
+		// Miss: take a free slot, or replace the least recently used layout that is not
+		// referenced by the current frame. The cache only grows past its size when a single
+		// frame uses more distinct strings than that.
+		uint32_t index = static_cast<uint32_t>(layouts.size());
+		if (layouts.size() >= LayoutCacheSize) {
+			for (uint32_t i = 0; i < layouts.size(); i++) {
+				if (layouts[i].lastUsed < frame && (index == layouts.size() || layouts[i].lastUsed < layouts[index].lastUsed)) {
+					index = i;
+				}
+			}
+		}
+		if (index == layouts.size()) {
+			layouts.emplace_back();
+		} else {
+			// previousItems may point at the old content of the slot
+			layoutsChanged = true;
+		}
+
+		Layout& layout = layouts[index];
+		layout.text = text;
+		layout.scale = scale;
+		layout.hash = hash;
+		layout.lastUsed = frame;
+		LayOut(layout);
+		return index;
+	}
+
+	void TextRenderer::Add(const char* text, glm::vec2 position, float scale, glm::vec4 color) {
+		if (text == nullptr || text[0] == '\0') {
+			return;
+		}
+
+		items.push_back(DrawItem { FindLayout(text, scale), position, PackColor(color) });
+	}
+
+	glm::vec2 TextRenderer::Measure(const char* text, float scale) {
+		if (text == nullptr || text[0] == '\0') {
+			return glm::vec2(0.0f);
+		}
+
+		return layouts[FindLayout(text, scale)].extent;
+	}
+
+	void TextRenderer::Rebuild() {
+		TRACE_ZONE("TextRenderer::Rebuild");
+		vertexData.clear();
+
+		const glm::vec2 cellUv(static_cast<float>(GlyphSize) / AtlasSize.x, static_cast<float>(GlyphSize) / AtlasSize.y);
+		unsigned int glyphs = 0;
+		for (const DrawItem& item : items) {
+			const Layout& layout = layouts[item.layout];
+			float size = GlyphSize * layout.scale;
+			for (const Glyph& glyph : layout.glyphs) {
+				if (glyphs == MaxGlyphs) {
+					LOG_WARN("GL", "TextRenderer: more than %u glyphs in a frame, the rest is not drawn", MaxGlyphs);
+					break;
+				}
+
+				glm::vec2 min = item.position + glyph.offset;
+				glm::vec2 max = min + glm::vec2(size, size);
+				glm::vec2 uvMin = glm::vec2(static_cast<float>(glyph.atlasIndex % AtlasColumns), static_cast<float>(glyph.atlasIndex / AtlasColumns)) * cellUv;
+				glm::vec2 uvMax = uvMin + cellUv;
+
+				vertexData.push_back(Vertex { min.x, min.y, uvMin.x, uvMin.y, item.color });
+				vertexData.push_back(Vertex { max.x, min.y, uvMax.x, uvMin.y, item.color });
+				vertexData.push_back(Vertex { max.x, max.y, uvMax.x, uvMax.y, item.color });
+				vertexData.push_back(Vertex { min.x, max.y, uvMin.x, uvMax.y, item.color });
+				glyphs++;
+			}
+		}
+
+		auto vertexBuffer = resources->vertexBuffers.Get(vertices);
+		if (vertexBuffer != nullptr) {
+			vertexBuffer->Stream(vertexData.data(), vertexData.size() * sizeof(Vertex));
+		}
+		uploadedGlyphs = glyphs;
+	}
+
+	void TextRenderer::Draw(glm::ivec2 screenSize) {
+		TRACE_ZONE("TextRenderer::Draw");
+		if (layoutsChanged || items.size() != previousItems.size() || !std::equal(items.begin(), items.end(), previousItems.begin())) {
+			Rebuild();
+			layoutsChanged = false;
+		}
+		previousItems.swap(items);
+		items.clear();
+		frame++;
+
+		const Texture* texture = resources->textures.Get(atlas);
+		if (uploadedGlyphs == 0 || program == 0 || vao == 0 || texture == nullptr) {
+			return;
+		}
+
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glDisable(GL_DEPTH_TEST);
+
+		glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(screenSize.x), static_cast<float>(screenSize.y), 0.0f, -1.0f, 1.0f);
+		glUseProgram(program);
+		glUniformMatrix4fv(uProjectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, texture->Id());
+		glUniform1i(uAtlasLoc, 0);
+
+		glBindVertexArray(vao);
+		glDrawElements(GL_TRIANGLES, uploadedGlyphs * 6, GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(indices.offset));
+		glBindVertexArray(0);
+
+		if (depthTest) {
+			glEnable(GL_DEPTH_TEST);
+		}
+	}
+
+	TextRenderer::~TextRenderer() {
+		if (program != 0) {
+			glDeleteProgram(program);
+			program = 0;
+		}
+		if (vao != 0) {
+			glDeleteVertexArrays(1, &vao);
+			vao = 0;
+		}
+
+		resources->textures.Release(atlas);
+		resources->vertexBuffers.Release(vertices);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+#include "../fix_vscode.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "gl_resources.hpp"
+
+namespace gl {
+	// Batched bitmap text for HUDs and stats overlays.
+	// A built-in 8x8 font is rasterized into a single-channel atlas at startup. Strings added
+	// during a frame are expanded into one streaming vertex buffer and drawn by Draw() with a
+	// single draw call. Glyph layouts are cached per (string, scale), and when a frame adds
+	// exactly the same text as the previous one the buffer is not rebuilt or uploaded at all.
+	class TextRenderer {
+	public:
+		static constexpr unsigned int GlyphSize = 8;
+		static constexpr unsigned int MaxGlyphs = 4096;
+		static constexpr unsigned int LayoutCacheSize = 64;
+	protected:
+		struct Vertex {
+			float x, y;
+			float u, v;
+			uint32_t color;		// RGBA8
+		};
+
+		// A glyph of a laid out string, relative to the string origin
+		struct Glyph {
+			glm::vec2 offset;
+			uint8_t atlasIndex;	// Atlas cell, character - 32
+		};
+
+		struct Layout {
+			std::string text;
+			float scale;
+			uint32_t hash;
+			std::vector<Glyph> glyphs;
+			glm::vec2 extent;
+			unsigned long long lastUsed;
+		};
+
+		struct DrawItem {
+			uint32_t layout;
+			glm::vec2 position;
+			uint32_t color;
+
+			inline bool operator==(const DrawItem& other) const {
+				return layout == other.layout && position.x == other.position.x && position.y == other.position.y && color == other.color;
+			}
+		};
+
+		Resources* resources;
+		TextureHandle atlas;
+		VertexBufferHandle vertices;
+		BufferRange indices;
+		GLuint program;
+		GLuint vao;
+		GLint uProjectionLoc;
+		GLint uAtlasLoc;
+
+		std::vector<Layout> layouts;
+		std::vector<DrawItem> items;
+		std::vector<DrawItem> previousItems;
+		std::vector<Vertex> vertexData;
+		unsigned int uploadedGlyphs;
+		bool layoutsChanged;
+		unsigned long long frame;
+
+		bool CreateAtlas();
+		bool CreateProgram();
+		uint32_t FindLayout(const char* text, float scale);
+		void LayOut(Layout& layout) const;
+		void Rebuild();
+	public:
+		TextRenderer(Resources& resources);
+		TextRenderer(const TextRenderer&) = delete;
+		TextRenderer& operator=(const TextRenderer&) = delete;
+
+		// Queues text for this frame. position is the top-left corner of the first line in
+		// pixels (origin at the top-left of the screen), scale is screen pixels per font pixel.
+		// '\n' starts a new line, characters outside printable ASCII are drawn as '?'.
+		void Add(const char* text, glm::vec2 position, float scale = 2.0f, glm::vec4 color = glm::vec4(1.0f));
+		// Size in pixels of text drawn at scale
+		glm::vec2 Measure(const char* text, float scale = 2.0f);
+
+		// Draws everything added since the last call, on top of the scene
+		void Draw(glm::ivec2 screenSize);
+
+		~TextRenderer();
+	};
+}
\ No newline at end of file
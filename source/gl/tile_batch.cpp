@@ -0,0 +1,92 @@
+#include "tile_batch.hpp"
+#include "../core/log.hpp"
+#include "../core/trace.hpp"
+
+namespace gl {
+	TileBatch::TileBatch(Resources& resources) : resources(&resources), bucketCount(0), stats { 0, 0 } {
+		instanceBuffer = resources.vertexBuffers.Create();
+
+		auto buffer = resources.vertexBuffers.Get(instanceBuffer);
+		if (!resources.LoadTileAssets() || buffer == nullptr) {
+			LOG_ERROR("GL", "TileBatch: failed to allocate resources");
+			return;
+		}
+
+		buffer->Allocate(1024 * sizeof(TileInstance), GL_STREAM_DRAW);
+	}
+
+	TileBatch::Bucket& TileBatch::FindBucket(TextureHandle texture, TintMode tint, bool shapes) {
+		for (unsigned int i = 0; i < bucketCount; i++) {
+			if (buckets[i].shapes == shapes && buckets[i].texture == texture && buckets[i].tint == tint) {
+				return buckets[i];
+			}
+		}
+
+		// Buckets (and their instance storage) are kept between frames and only reset
+		if (bucketCount == buckets.size()) {
+			buckets.emplace_back();
+		}
+		Bucket& bucket = buckets[bucketCount++];
+		bucket.texture = texture;
+		bucket.tint = tint;
+		bucket.shapes = shapes;
+		bucket.instances.clear();
+		return bucket;
+	}
+
+	void TileBatch::Add(Bucket& bucket, glm::vec3 position, glm::vec2 size, glm::vec4 color, TileShape shape) {
+		glm::vec3 hsv = !bucket.shapes && bucket.tint == TintMode::Hsv ? rgbToHsv(glm::vec3(color.r, color.g, color.b)) : glm::vec3(0.0f);
+		bucket.instances.push_back(TileInstance {
+			position.x, position.y,
+			size.x, size.y,
+			color.r, color.g, color.b, color.a,
+			hsv.x, hsv.y, hsv.z,
+			position.z,
+			static_cast<float>(shape)
+		});
+	}
+
+	void TileBatch::Add(TextureHandle texture, glm::vec3 position, glm::vec2 size, glm::vec4 color, TintMode tint) {
+		Add(FindBucket(texture, tint, false), position, size, color, TileShape::None);
+	}
+
+	void TileBatch::Add(TileShape shape, glm::vec3 position, glm::vec2 size, glm::vec4 color) {
+		Add(FindBucket(TextureHandle(), TintMode::Hsv, true), position, size, color, shape);
+	}
+
+	void TileBatch::Draw(glm::mat4 vp) {
+		TRACE_ZONE("TileBatch::Draw");
+		stats = Stats { 0, 0 };
+
+		uploadData.clear();
+		for (unsigned int i = 0; i < bucketCount; i++) {
+			uploadData.insert(uploadData.end(), buckets[i].instances.begin(), buckets[i].instances.end());
+		}
+
+		TileShader* tileShader = resources->shaders.Get(resources->tileShader);
+		auto buffer = resources->vertexBuffers.Get(instanceBuffer);
+		TileMesh mesh = resources->tileQuad.Resolve(*resources);
+
+		if (!uploadData.empty() && tileShader != nullptr && buffer != nullptr && mesh.vertices != nullptr && mesh.indices != nullptr &&
+			buffer->Stream(uploadData.data(), uploadData.size() * sizeof(TileInstance))) {
+			GLuint first = 0;
+			for (unsigned int i = 0; i < bucketCount; i++) {
+				GLsizei count = static_cast<GLsizei>(buckets[i].instances.size());
+				tileShader->DrawInstanced(mesh, resources->textures.Get(buckets[i].texture), vp, buckets[i].tint, *buffer, first, count, buckets[i].shapes);
+				first += count;
+				stats.drawCalls++;
+			}
+			stats.instances = first;
+		}
+
+		for (unsigned int i = 0; i < bucketCount; i++) {
+			buckets[i].instances.clear();
+		}
+		bucketCount = 0;
+	}
+
+	TileBatch::~TileBatch() {
+		// The tile shader and quad are shared, they are released with Resources
+		resources->vertexBuffers.Release(instanceBuffer);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "../fix_vscode.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "gl_resources.hpp"
+#include "tile_shader.hpp"
+
+namespace gl {
+	// Instanced renderer for large numbers of tiles.
+	// Tiles added during a frame are bucketed by (texture, tint), and every SDF shape shares a
+	// single bucket whatever its shape. Draw() uploads every instance
+	// with a single streaming upload and issues one instanced draw call per bucket, so the cost
+	// on the CPU and in draw calls depends on the number of distinct textures, not of tiles.
+	class TileBatch {
+	public:
+		struct Stats {
+			unsigned int drawCalls;
+			unsigned int instances;
+		};
+	protected:
+		struct Bucket {
+			TextureHandle texture;
+			TintMode tint;
+			bool shapes;
+			std::vector<TileInstance> instances;
+		};
+
+		Resources* resources;
+		VertexBufferHandle instanceBuffer;
+
+		std::vector<Bucket> buckets;
+		unsigned int bucketCount;
+		std::vector<TileInstance> uploadData;
+		Stats stats;
+
+		Bucket& FindBucket(TextureHandle texture, TintMode tint, bool shapes);
+		void Add(Bucket& bucket, glm::vec3 position, glm::vec2 size, glm::vec4 color, TileShape shape);
+	public:
+		TileBatch(Resources& resources);
+		TileBatch(const TileBatch&) = delete;
+		TileBatch& operator=(const TileBatch&) = delete;
+
+		// Queues a tile for this frame, position is the center in the space of the vp given
+		// to Draw()
+		void Add(TextureHandle texture, glm::vec3 position, glm::vec2 size, glm::vec4 color, TintMode tint = TintMode::Hsv);
+		// Same for an SDF shape, drawn in the plain color
+		void Add(TileShape shape, glm::vec3 position, glm::vec2 size, glm::vec4 color);
+
+		// Draws and clears everything added since the last call
+		void Draw(glm::mat4 vp);
+
+		// Counts of the last Draw()
+		inline const Stats& LastStats() const { return stats; }
+
+		~TileBatch();
+	};
+}
\ No newline at end of file
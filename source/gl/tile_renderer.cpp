@@ -1,233 +1,328 @@
 #include "tile_renderer.hpp"
-#include <iostream>
-#include "tile_vs.h"
-#include "tile_fs.h"
+#include "../core/log.hpp"
+#include "../core/trace.hpp"
 #include <vector>
 #include <string>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
 namespace gl {
-	GLuint compileShader(const char* vs_source, size_t vs_length, const char* fs_source, size_t fs_length) {
-		auto vsId = glCreateShader(GL_VERTEX_SHADER);
+	Tile::Tile() : position(0, 0, 0), size(10, 10), color(0, 1, 0, 1), tint(TintMode::Hsv), texture(), shape(TileShape::None) {
 
-		GLint vs_size = static_cast<GLint>(vs_length);
-		glShaderSource(vsId, 1, &vs_source, &vs_size);
+	}
 
-		glCompileShader(vsId);
+	void Tile::Draw(const TileMesh& mesh, TileShader& shader, const Resources& resources, glm::mat4 vp) {
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		model = glm::scale(model, glm::vec3(size.x, size.y, 1.0));
+		glm::mat4 mvp = vp * model;
 
-		GLint info_log_size = 0;
-		glGetShaderiv(vsId, GL_INFO_LOG_LENGTH, &info_log_size);
-		if (info_log_size > 0) {
-			std::vector<char> data(0, info_log_size);
-			glGetShaderInfoLog(vsId, data.size(), nullptr, &data[0]);
-			std::cout << "[GL] VS Shader info log: " << std::endl << std::string(data.begin(), data.end()) << std::endl;
-		}
+		shader.Draw(mesh, resources.textures.Get(texture), color, mvp, tint, shape);
+	}
 
-		GLint shader_compile_status = GL_FALSE;
-		glGetShaderiv(vsId, GL_COMPILE_STATUS, &shader_compile_status);
-		if (shader_compile_status != GL_TRUE) {
-			return 0;
+	// Selection pulse period, |sin(3t)|
+	constexpr float SelectionPeriod = 3.14159265f / 3.0f;
+
+	TileRenderer::TileRenderer(Resources& resources) : resources(&resources), layoutSize(0, 0), layoutGap(0), vp(1.0f), compositeMvp(1.0f),
+		layerValid(false), animationsDirty(true), selectionActive(false), selection(0, 0), selectionColor(1.0f) {
+		layer = resources.framebuffers.Create();
+		instanceBuffer = resources.vertexBuffers.Create();
+		animationBuffer = resources.vertexBuffers.Create();
+		animatedGroups.reserve(TileCount);
+
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++) {
+				animations[y][x].event = TileAnimation::Make(AnimationCurve::None, 0.0f, 1.0f, 1.0f, glm::vec4(1.0f));
+				animations[y][x].loop = animations[y][x].event;
+				keys[y][x] = TileKey { TextureHandle(), glm::vec4(-1.0f), TintMode::Hsv, TileShape::None, false };
+			}
 		}
 
-		auto fsId = glCreateShader(GL_FRAGMENT_SHADER);
-		GLint fs_size = static_cast<GLint>(fs_length);
-		glShaderSource(fsId, 1, &fs_source, &fs_size);
+		auto instances = resources.vertexBuffers.Get(instanceBuffer);
+		auto animated = resources.vertexBuffers.Get(animationBuffer);
+		if (!resources.LoadTileAssets() || instances == nullptr || animated == nullptr) {
+			LOG_ERROR("GL", "TileRenderer: failed to allocate resources");
+			return;
+		}
 
-		glCompileShader(fsId);
+		instances->Allocate(TileCount * sizeof(TileInstance), GL_DYNAMIC_DRAW);
+		animated->Allocate(TileCount * sizeof(TileAnimationInstance), GL_DYNAMIC_DRAW);
+	}
 
-		glGetShaderiv(fsId, GL_INFO_LOG_LENGTH, &info_log_size);
-		if (info_log_size > 0) {
-			std::vector<char> data(0, info_log_size);
-			glGetShaderInfoLog(fsId, data.size(), nullptr, &data[0]);
-			std::cout << "[GL] FS Shader info log: " << std::endl << std::string(data.begin(), data.end()) << std::endl;
+	Tile* TileRenderer::Get(unsigned int x, unsigned int y) {
+		if (x < 0 || x >= 3 || y < 0 || y >= 3) {
+			return nullptr;
 		}
 
-		glGetShaderiv(fsId, GL_COMPILE_STATUS, &shader_compile_status);
-		if (shader_compile_status != GL_TRUE) {
-			return 0;
+		return &tiles[y][x];
+	}
+
+	void TileRenderer::Animate(unsigned int x, unsigned int y, AnimationTrack track, const TileAnimation& animation) {
+		if (x >= 3 || y >= 3) {
+			return;
 		}
 
-		GLuint id = glCreateProgram();
-		glAttachShader(id, vsId);
-		glAttachShader(id, fsId);
+		(track == AnimationTrack::Event ? animations[y][x].event : animations[y][x].loop) = animation;
+		animationsDirty = true;
+	}
 
-		glLinkProgram(id);
+	void TileRenderer::StopAnimation(unsigned int x, unsigned int y, AnimationTrack track) {
+		if (x >= 3 || y >= 3) {
+			return;
+		}
 
-		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &info_log_size);
-		if (info_log_size > 0) {
-			std::vector<char> data(0, info_log_size);
-			glGetProgramInfoLog(id, data.size(), nullptr, &data[0]);
-			std::cout << "[GL] Program info log: " << std::endl << std::string(data.begin(), data.end()) << std::endl;
+		TileAnimation& animation = track == AnimationTrack::Event ? animations[y][x].event : animations[y][x].loop;
+		if (animation.Curve() != AnimationCurve::None) {
+			animation.curve = static_cast<float>(AnimationCurve::None);
+			animationsDirty = true;
 		}
+	}
 
-		glGetProgramiv(id, GL_LINK_STATUS, &shader_compile_status);
-		if (shader_compile_status != GL_TRUE) {
-			return 0;
+	void TileRenderer::SetSelection(unsigned int x, unsigned int y, glm::vec4 color, float time) {
+		if (selectionActive && selection == glm::uvec2(x, y) && selectionColor == color) {
+			return;
 		}
 
-		glDeleteShader(vsId);
-		glDeleteShader(fsId);
+		ClearSelection();
+		if (x >= 3 || y >= 3) {
+			return;
+		}
 
-		return id;
+		selectionActive = true;
+		selection = glm::uvec2(x, y);
+		selectionColor = color;
+		Animate(x, y, AnimationTrack::Loop, TileAnimation::Make(AnimationCurve::Pulse, time, SelectionPeriod, 1.0f, color));
 	}
 
-	TileShader::TileShader() : id(0) {
-
+	void TileRenderer::ClearSelection() {
+		if (selectionActive) {
+			StopAnimation(selection.x, selection.y, AnimationTrack::Loop);
+		}
+		selectionActive = false;
 	}
 
-	bool TileShader::Load() {
-		id = compileShader(reinterpret_cast<const char*>(tile_vs), tile_vs_size, reinterpret_cast<const char*>(tile_fs), tile_fs_size);
+	void TileRenderer::Layout(glm::ivec2 screenSize, int gap) {
+		vp = glm::ortho(-screenSize.x / 2.0f, screenSize.x / 2.0f, -screenSize.y / 2.0f, screenSize.y / 2.0f, 0.1f, 100.0f);
 
-		if (id != 0) {
-			aPosLoc = glGetAttribLocation(id, "aPos");
-			aUvLoc = glGetAttribLocation(id, "aUv");
+		glm::ivec2 availableSpace = (screenSize - (gap * 4)) / 3;
+		glm::ivec2 cellSize = glm::ivec2(glm::min(availableSpace.x, availableSpace.y));
 
-			uMvpLoc = glGetUniformLocation(id, "uMvp");
-			uColorLoc = glGetUniformLocation(id, "uColor");
-			uTextureLoc = glGetUniformLocation(id, "uTexture");
-			uTextureEnabledLoc = glGetUniformLocation(id, "uTextureEnabled");
+		for(int x = 0; x < 3; x++) {
+			for(int y = 0; y < 3; y++) {
+				tiles[y][x].size = cellSize;
+				glm::vec3 offset;
+				offset.x = (cellSize.x + gap) * (x - 1);
+				offset.y = (cellSize.y + gap) * (y - 1);
+				offset.z = -1;
+				tiles[y][x].position = offset;
+			}
+		}
 
+		// Full-screen quad sampling the layer. Its height is negated because framebuffer
+		// textures start at the bottom row, while the tile quad maps v = 0 to the top.
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+		model = glm::scale(model, glm::vec3(screenSize.x, -screenSize.y, 1.0f));
+		compositeMvp = vp * model;
 
-			std::cout << "[GL] Shader Locs: " << aPosLoc << " " << aUvLoc << " / " << uMvpLoc << " " << uColorLoc << " " << uTextureLoc << " " << uTextureEnabledLoc << std::endl;
+		layoutSize = screenSize;
+		layoutGap = gap;
+		animationsDirty = true;
+	}
 
-			return true;
+	bool TileRenderer::TilesChanged() const {
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++) {
+				const Tile& tile = tiles[y][x];
+				const TileKey& key = keys[y][x];
+				if (tile.texture != key.texture || tile.shape != key.shape || tile.tint != key.tint || tile.color != key.color || IsAnimated(x, y) != key.animated) {
+					return true;
+				}
+			}
 		}
-		std::cout << "[GL] Shader compilation failed. " << std::endl;
+
 		return false;
 	}
 
-	void TileShader::Draw(Buffer<GL_ARRAY_BUFFER>& pos, Buffer<GL_ARRAY_BUFFER>& uv, Buffer<GL_ELEMENT_ARRAY_BUFFER>& indices, std::shared_ptr<Texture> texture, glm::vec4 color, glm::mat4 mvp, GLint amount) {
-		if (id == 0) {
-			return;
+	void TileRenderer::UpdateKeys() {
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++) {
+				const Tile& tile = tiles[y][x];
+				keys[y][x] = TileKey { tile.texture, tile.color, tile.tint, tile.shape, IsAnimated(x, y) };
+			}
 		}
+	}
 
-		if (vao == 0) {
-			glGenVertexArrays(1, &vao);
+	bool TileRenderer::RenderLayer(const TileMesh& mesh, TileShader& tileShader) {
+		TRACE_ZONE("TileRenderer::RenderLayer");
+		Framebuffer* framebuffer = resources->framebuffers.Get(layer);
+		// The frame may be drawn offscreen itself (dynamic resolution), hand its target back after
+		FramebufferBinding previous = FramebufferBinding::Current();
+		if (framebuffer == nullptr || !framebuffer->Allocate(layoutSize) || !framebuffer->Bind()) {
+			previous.Restore();
+			return false;
 		}
-		glBindVertexArray(vao);
 
-		glUseProgram(id);
+		// Cleared with the screen clear color, so the layer can be copied over the screen as is.
+		// Animated tiles are left out, they are drawn on top every frame.
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++) {
+				if (!keys[y][x].animated) {
+					tiles[y][x].Draw(mesh, tileShader, *resources, vp);
+				}
+			}
+		}
+		previous.Restore();
 
-		glUniformMatrix4fv(uMvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
-		glUniform4f(uColorLoc, color.r, color.g, color.b, color.a);
+		layerValid = true;
+		return true;
+	}
 
-		if (texture != nullptr && texture->Id() > 0) {
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, texture->Id());
-			glUniform1i(uTextureLoc, 0);
-			glUniform1i(uTextureEnabledLoc, 1);
-		} else {
-			glUniform1i(uTextureEnabledLoc, 0);
+	void TileRenderer::UploadAnimated() {
+		TRACE_ZONE("TileRenderer::UploadAnimated");
+		TileInstance instances[TileCount];
+		TileAnimationInstance animated[TileCount];
+		animatedGroups.clear();
+
+		// Animated tiles sharing a texture (or drawn as shapes) are packed next to each other,
+		// so each group is a single instanced draw
+		GLuint count = 0;
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++) {
+				if (!keys[y][x].animated) {
+					continue;
+				}
+
+				const Tile& tile = tiles[y][x];
+				bool shapes = tile.shape != TileShape::None;
+				AnimatedGroup* group = nullptr;
+				for (auto& g : animatedGroups) {
+					if (g.shapes == shapes && (shapes || (g.texture == tile.texture && g.tint == tile.tint))) {
+						group = &g;
+						break;
+					}
+				}
+				if (group == nullptr) {
+					animatedGroups.push_back(AnimatedGroup { tile.texture, tile.tint, shapes, 0, 0 });
+					group = &animatedGroups.back();
+				}
+				group->count++;
+			}
 		}
 
-		if (!pos.Bind()) {
-			std::cout << "[GL] Failed to bind position " << std::endl;
-			return;
+		for (auto& g : animatedGroups) {
+			g.first = count;
+			count += g.count;
+			g.count = 0;
 		}
 
-		glEnableVertexAttribArray(aPosLoc);
-		glVertexAttribPointer(aPosLoc, 3, GL_FLOAT, false, 0, 0);
-
-		if (aUvLoc >= 0) {
-			if (!uv.Bind()) {
-				glDisableVertexAttribArray(aPosLoc);
-				std::cout << "[GL] Failed to bind uv " << std::endl;
-				return;
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++) {
+				if (!keys[y][x].animated) {
+					continue;
+				}
+
+				const Tile& tile = tiles[y][x];
+				bool shapes = tile.shape != TileShape::None;
+				for (auto& g : animatedGroups) {
+					if (g.shapes == shapes && (shapes || (g.texture == tile.texture && g.tint == tile.tint))) {
+						GLuint index = g.first + g.count++;
+						glm::vec3 hsv = !shapes && tile.tint == TintMode::Hsv ? rgbToHsv(glm::vec3(tile.color.r, tile.color.g, tile.color.b)) : glm::vec3(0.0f);
+						instances[index] = TileInstance {
+							tile.position.x, tile.position.y,
+							tile.size.x, tile.size.y,
+							tile.color.r, tile.color.g, tile.color.b, tile.color.a,
+							hsv.x, hsv.y, hsv.z,
+							tile.position.z,
+							static_cast<float>(tile.shape)
+						};
+						animated[index] = animations[y][x];
+						break;
+					}
+				}
 			}
+		}
 
-			glEnableVertexAttribArray(aUvLoc);
-			glVertexAttribPointer(aUvLoc, 2, GL_FLOAT, false, 0, 0);
+		auto instanceData = resources->vertexBuffers.Get(instanceBuffer);
+		auto animationData = resources->vertexBuffers.Get(animationBuffer);
+		if (count > 0 && (instanceData == nullptr || animationData == nullptr || !instanceData->Update(instances, count, 0) || !animationData->Update(animated, count, 0))) {
+			LOG_WARN("GL", "TileRenderer: failed to upload the animated tiles");
+			animatedGroups.clear();
 		}
+		animationsDirty = false;
+	}
 
-		if (!indices.Bind()) {
-			std::cout << "[GL] Failed to bind indices " << std::endl;
-			glDisableVertexAttribArray(aUvLoc);
-			glDisableVertexAttribArray(aPosLoc);
+	void TileRenderer::Draw(glm::ivec2 screenSize, int gap, float time) {
+		TRACE_ZONE("TileRenderer::Draw");
+		TileShader* tileShader = resources->shaders.Get(resources->tileShader);
+		TileMesh mesh = resources->tileQuad.Resolve(*resources);
+		if (tileShader == nullptr || mesh.vertices == nullptr || mesh.indices == nullptr) {
 			return;
 		}
 
-		glDrawElements(GL_TRIANGLES, amount, GL_UNSIGNED_SHORT, 0);
-
-		if (aUvLoc >= 0) {
-			glDisableVertexAttribArray(aUvLoc);
+		if (screenSize != layoutSize || gap != layoutGap) {
+			Layout(screenSize, gap);
+			layerValid = false;
 		}
-		glDisableVertexAttribArray(aPosLoc);
-	}
 
-	TileShader::~TileShader() {
-		if (id != 0) {
-			std::cout << "[GL] Shader: deleting shader " << id << std::endl;
-			glDeleteProgram(id);
-			id = 0;
+		// Settled one-shot animations are dropped, which moves their tile back into the layer
+		for (int y = 0; y < 3; y++) {
+			for (int x = 0; x < 3; x++) {
+				TileAnimation& event = animations[y][x].event;
+				if (event.Curve() != AnimationCurve::None && !event.IsActive(time)) {
+					StopAnimation(x, y, AnimationTrack::Event);
+				}
+			}
 		}
 
-		if (vao != 0) {
-			glDeleteVertexArrays(1, &vao);
-			vao = 0;
+		if (TilesChanged()) {
+			UpdateKeys();
+			layerValid = false;
+			animationsDirty = true;
 		}
-	}
-
-	Tile::Tile() : position(0, 0, 0), size(10, 10), color(0, 1, 0, 1), texture(nullptr) {
 
-	}
-
-	void Tile::Draw(TileData& data, TileShader& shader, glm::mat4 vp) {
-		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
-		model = glm::scale(model, glm::vec3(size.x, size.y, 1.0));
-		glm::mat4 mvp = vp * model;
-
-		shader.Draw(data.pos, data.uv, data.indices, texture, color, mvp, data.amount);
-	}
-
-	TileRenderer::TileRenderer() {
-		data = std::make_shared<TileData>();
-		data->pos.Load(std::vector<float>({
-			-0.5f, -0.5f, 0.0f,
-			0.5f, -0.5f, 0.0f,
-			0.5f, 0.5f, 0.0f,
-			-0.5f, 0.5f, 0.0f
-		}));
-		data->uv.Load(std::vector<float>({
-			0.0f, 1.0f,
-			1.0f, 1.0f,
-			1.0f, 0.0f,
-			0.0f, 0.0f
-		}));
-		data->indices.Load(std::vector<unsigned short>({
-			0, 1, 2,
-			0, 2, 3
-		}));
-		data->amount = 6;
-		shader = std::make_shared<TileShader>();
-		shader->Load();
-	}
-
-	Tile* TileRenderer::Get(unsigned int x, unsigned int y) {
-		if (x < 0 || x >= 3 || y < 0 || y >= 3) {
-			return nullptr;
+		if (layer.IsValid() && !layerValid && !RenderLayer(mesh, *tileShader)) {
+			LOG_WARN("GL", "TileRenderer: offscreen layer unavailable, drawing tiles directly");
+			resources->framebuffers.Release(layer);
+			layer = FramebufferHandle();
 		}
 
-		return &tiles[y][x];
-	}
-
-	void TileRenderer::Draw(glm::ivec2 screenSize, int gap) {
-		glm::mat4 vp = glm::ortho(-screenSize.x / 2.0f, screenSize.x / 2.0f, -screenSize.y / 2.0f, screenSize.y / 2.0f, 0.1f, 100.0f);
-
-		glm::ivec2 availableSpace = (screenSize - (gap * 4)) / 3;
-		glm::ivec2 cellSize = glm::ivec2(glm::min(availableSpace.x, availableSpace.y));
+		const Framebuffer* framebuffer = resources->framebuffers.Get(layer);
+		if (layerValid && framebuffer != nullptr && framebuffer->IsValid()) {
+			// The layer already contains the blended tiles, copy it over the screen unblended
+			GLboolean blend = glIsEnabled(GL_BLEND);
+			glDisable(GL_BLEND);
+			tileShader->Draw(mesh, framebuffer->Color(), glm::vec4(1.0f), compositeMvp, TintMode::Multiply);
+			if (blend) {
+				glEnable(GL_BLEND);
+			}
+		} else {
+			// No offscreen layer available, draw every static tile directly
+			for (int y = 0; y < 3; y++) {
+				for (int x = 0; x < 3; x++) {
+					if (!keys[y][x].animated) {
+						tiles[y][x].Draw(mesh, *tileShader, *resources, vp);
+					}
+				}
+			}
+		}
 
-		for(int x = 0; x < 3; x++) {
-			for(int y = 0; y < 3; y++) {
-				tiles[y][x].size = cellSize;
-				glm::vec3 offset;
-				offset.x = (cellSize.x + gap) * (x - 1);
-				offset.y = (cellSize.y + gap) * (y - 1);
-				offset.z = -1;
-				tiles[y][x].position = offset;
+		if (animationsDirty) {
+			UploadAnimated();
+		}
 
-				tiles[y][x].Draw(*data, *shader, vp);
+		auto instanceData = resources->vertexBuffers.Get(instanceBuffer);
+		auto animationData = resources->vertexBuffers.Get(animationBuffer);
+		if (instanceData != nullptr && animationData != nullptr) {
+			for (const auto& g : animatedGroups) {
+				tileShader->DrawInstanced(mesh, resources->textures.Get(g.texture), vp, g.tint, *instanceData, g.first, g.count, g.shapes, animationData, time);
 			}
 		}
 	}
+
+	TileRenderer::~TileRenderer() {
+		// The tile shader and quad are shared, they are released with Resources
+		resources->framebuffers.Release(layer);
+		resources->vertexBuffers.Release(instanceBuffer);
+		resources->vertexBuffers.Release(animationBuffer);
+	}
 }
\ No newline at end of file
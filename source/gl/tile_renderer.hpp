@@ -3,63 +3,113 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <vector>
 #include "gl_buffer.hpp"
 #include "gl_texture.hpp"
+#include "gl_resources.hpp"
+#include "tile_shader.hpp"
 
 namespace gl {
-
-	class TileShader {
-	protected:
-		GLuint id;
-		GLuint vao;
-
-		GLint aPosLoc, aUvLoc;
-		GLint uMvpLoc;
-		GLint uColorLoc;
-		GLint uTextureLoc;
-		GLint uTextureEnabledLoc;
-	public:
-		TileShader();
-		TileShader(const TileShader&) = delete;
-
-		TileShader& operator=(const TileShader&) = delete;
-
-		bool Load();
-
-		void Draw(Buffer<GL_ARRAY_BUFFER>& pos, Buffer<GL_ARRAY_BUFFER>& uv, Buffer<GL_ELEMENT_ARRAY_BUFFER>& indices, std::shared_ptr<Texture> texture,  glm::vec4 color, glm::mat4 mvp, GLint amount);
-
-		~TileShader();
-	};
-
-	class TileData {
-	public: 
-		Buffer<GL_ARRAY_BUFFER> pos;
-		Buffer<GL_ARRAY_BUFFER> uv;
-		Buffer<GL_ELEMENT_ARRAY_BUFFER> indices;
-		GLint amount;
-	};
-
 	class Tile {
 	public:
 		glm::vec3 position;
 		glm::vec2 size;
 		glm::vec4 color;
-		std::shared_ptr<Texture> texture;
+		TintMode tint;
+		TextureHandle texture;
+		// When not None the shape is drawn analytically instead of texture
+		TileShape shape;
 
 		Tile();
-		void Draw(TileData& data, TileShader& shader, glm::mat4 vp);
+		void Draw(const TileMesh& mesh, TileShader& shader, const Resources& resources, glm::mat4 vp);
 	};
 
+	// Animation slots of a tile, both can run at the same time
+	enum class AnimationTrack {
+		Event,	// One-shot animations, such as placements
+		Loop	// Repeating animations, such as the selection pulse
+	};
+
+	// Draws the 3x3 board. The static layer (every tile that is not animated, with its texture
+	// and base color) is rendered into an offscreen framebuffer and only re-rendered when a tile
+	// changes or the screen is resized. Animated tiles are drawn on top of it by instanced draws
+	// that evaluate the animations on the GPU; their instance data is only written when an
+	// animation starts or ends, so every other frame costs the cached layer plus a draw per
+	// texture of the animated tiles, without per-tile uniforms.
 	class TileRenderer {
+	public:
+		static constexpr unsigned int TileCount = 9;
 	protected:
-		std::shared_ptr<TileData> data;
-		std::shared_ptr<TileShader> shader;
+		// What a tile looked like when the layer and the animated instances were last built
+		struct TileKey {
+			TextureHandle texture;
+			glm::vec4 color;
+			TintMode tint;
+			TileShape shape;
+			bool animated;
+		};
+
+		// A range of animated instances drawn by one instanced draw
+		struct AnimatedGroup {
+			TextureHandle texture;
+			TintMode tint;
+			bool shapes;
+			GLuint first;
+			GLsizei count;
+		};
+
+		Resources* resources;
+		FramebufferHandle layer;
+		VertexBufferHandle instanceBuffer;
+		VertexBufferHandle animationBuffer;
 		Tile tiles[3][3];
+		TileAnimationInstance animations[3][3];
+
+		glm::ivec2 layoutSize;
+		int layoutGap;
+		glm::mat4 vp;
+		glm::mat4 compositeMvp;
 
+		TileKey keys[3][3];
+		bool layerValid;
+		bool animationsDirty;
+		std::vector<AnimatedGroup> animatedGroups;
+
+		bool selectionActive;
+		glm::uvec2 selection;
+		glm::vec4 selectionColor;
+
+		void Layout(glm::ivec2 screenSize, int gap);
+		inline bool IsAnimated(unsigned int x, unsigned int y) const {
+			return animations[y][x].event.Curve() != AnimationCurve::None || animations[y][x].loop.Curve() != AnimationCurve::None;
+		}
+		bool TilesChanged() const;
+		void UpdateKeys();
+		bool RenderLayer(const TileMesh& mesh, TileShader& tileShader);
+		// Rewrites the instance and animation buffers of the animated tiles
+		void UploadAnimated();
 	public:
-		TileRenderer();
+		TileRenderer(Resources& resources);
+		TileRenderer(const TileRenderer&) = delete;
+		TileRenderer& operator=(const TileRenderer&) = delete;
+
 		Tile* Get(unsigned int x, unsigned int y);
 
-		void Draw(glm::ivec2 screen_size, int gap = 0);
+		// Starts animation on a track of a tile, replacing what was running there. One-shot
+		// animations end by themselves, loops run until stopped.
+		void Animate(unsigned int x, unsigned int y, AnimationTrack track, const TileAnimation& animation);
+		void StopAnimation(unsigned int x, unsigned int y, AnimationTrack track);
+
+		// Highlights a tile with a pulse towards color on its loop track, starting at time.
+		// Selecting the same tile again keeps the running pulse.
+		void SetSelection(unsigned int x, unsigned int y, glm::vec4 color, float time);
+		void ClearSelection();
+		// Forces the cached layer to be re-rendered by the next Draw()
+		inline void Invalidate() { layerValid = false; }
+
+		// time is the clock of the animations, in seconds
+		void Draw(glm::ivec2 screen_size, int gap = 0, float time = 0.0f);
+
+		~TileRenderer();
 	};
 }
\ No newline at end of file
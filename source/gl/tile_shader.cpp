@@ -0,0 +1,390 @@
+#include "tile_shader.hpp"
+#include "../core/log.hpp"
+#include "../core/trace.hpp"
+#include "tile_vs.h"
+#include "tile_fs.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace gl {
+	namespace {
+		// Info logs are usually longer than a log record, so they are logged one line at a time
+		void logInfoLog(const char* name, const std::vector<char>& data) {
+			LOG_INFO("GL", "%s info log:", name);
+
+			size_t lineStart = 0;
+			for (size_t i = 0; i <= data.size(); i++) {
+				if (i == data.size() || data[i] == '\n' || data[i] == '\0') {
+					if (i > lineStart) {
+						LOG_INFO("GL", "  %.*s", static_cast<int>(i - lineStart), &data[lineStart]);
+					}
+					if (i < data.size() && data[i] == '\0') {
+						break;
+					}
+					lineStart = i + 1;
+				}
+			}
+		}
+
+		// Compiles a single shader stage. When defines is not null it is injected right after the
+		// leading #version line of the source, which is how shader permutations are specialized.
+		GLuint compileStage(GLenum type, const char* source, size_t length, const char* defines, const char* name) {
+			const char* sources[3];
+			GLint sizes[3];
+			GLsizei count = 0;
+
+			size_t versionLength = 0;
+			if (defines != nullptr && length > 8 && std::strncmp(source, "#version", 8) == 0) {
+				while (versionLength < length && source[versionLength] != '\n') {
+					versionLength++;
+				}
+				if (versionLength < length) {
+					versionLength++;
+				}
+
+				sources[count] = source;
+				sizes[count++] = static_cast<GLint>(versionLength);
+			}
+
+			if (defines != nullptr) {
+				sources[count] = defines;
+				sizes[count++] = static_cast<GLint>(std::strlen(defines));
+			}
+
+			sources[count] = source + versionLength;
+			sizes[count++] = static_cast<GLint>(length - versionLength);
+
+			auto stageId = glCreateShader(type);
+			glShaderSource(stageId, count, sources, sizes);
+
+			glCompileShader(stageId);
+
+			GLint info_log_size = 0;
+			glGetShaderiv(stageId, GL_INFO_LOG_LENGTH, &info_log_size);
+			if (info_log_size > 0) {
+				std::vector<char> data(info_log_size, 0);
+				glGetShaderInfoLog(stageId, data.size(), nullptr, &data[0]);
+				logInfoLog(name, data);
+			}
+
+			GLint shader_compile_status = GL_FALSE;
+			glGetShaderiv(stageId, GL_COMPILE_STATUS, &shader_compile_status);
+			if (shader_compile_status != GL_TRUE) {
+				glDeleteShader(stageId);
+				return 0;
+			}
+
+			return stageId;
+		}
+	}
+
+	GLuint compileShader(const char* vs_source, size_t vs_length, const char* fs_source, size_t fs_length, const char* defines) {
+		TRACE_ZONE("compileShader");
+		auto vsId = compileStage(GL_VERTEX_SHADER, vs_source, vs_length, defines, "VS Shader");
+		if (vsId == 0) {
+			return 0;
+		}
+
+		auto fsId = compileStage(GL_FRAGMENT_SHADER, fs_source, fs_length, defines, "FS Shader");
+		if (fsId == 0) {
+			glDeleteShader(vsId);
+			return 0;
+		}
+
+		GLuint id = glCreateProgram();
+		glAttachShader(id, vsId);
+		glAttachShader(id, fsId);
+
+		glLinkProgram(id);
+
+		GLint info_log_size = 0;
+		glGetProgramiv(id, GL_INFO_LOG_LENGTH, &info_log_size);
+		if (info_log_size > 0) {
+			std::vector<char> data(info_log_size, 0);
+			glGetProgramInfoLog(id, data.size(), nullptr, &data[0]);
+			logInfoLog("Program", data);
+		}
+
+		glDeleteShader(vsId);
+		glDeleteShader(fsId);
+
+		GLint link_status = GL_FALSE;
+		glGetProgramiv(id, GL_LINK_STATUS, &link_status);
+		if (link_status != GL_TRUE) {
+			glDeleteProgram(id);
+			return 0;
+		}
+
+		return id;
+	}
+
+	// CPU side of tile.fs' rgb2hsv, the tint color is constant across a draw so there is
+	// no point in converting it once per fragment
+	glm::vec3 rgbToHsv(glm::vec3 c) {
+		float maxC = glm::max(c.x, glm::max(c.y, c.z));
+		float minC = glm::min(c.x, glm::min(c.y, c.z));
+		float d = maxC - minC;
+		constexpr float e = 1.0e-10f;
+
+		float h = 0.0f;
+		if (d > 0.0f) {
+			if (maxC == c.x) {
+				h = (c.y - c.z) / (6.0f * d);
+			} else if (maxC == c.y) {
+				h = (c.z - c.x) / (6.0f * d) + 1.0f / 3.0f;
+			} else {
+				h = (c.x - c.y) / (6.0f * d) + 2.0f / 3.0f;
+			}
+			if (h < 0.0f) {
+				h += 1.0f;
+			}
+		}
+
+		return glm::vec3(h, d / (maxC + e), maxC);
+	}
+
+	TileShader::TileShader() : vao(0) {
+		for (auto& v : variants) {
+			v.id = 0;
+		}
+	}
+
+	int TileShader::VariantIndex(bool textured, TintMode tint, bool instanced, bool shapes, bool animated) {
+		int base = animated ? 8 : instanced ? 4 : 0;
+		if (shapes) {
+			return base + 3;
+		}
+		if (!textured) {
+			return base;
+		}
+
+		return base + (tint == TintMode::Hsv ? 1 : 2);
+	}
+
+	bool TileShader::Load() {
+		static const char* const defines[VariantCount] = {
+			"\n",
+			"#define TEXTURED\n#define TINT_HSV\n",
+			"#define TEXTURED\n",
+			"#define SDF\n",
+			"#define INSTANCED\n",
+			"#define INSTANCED\n#define TEXTURED\n#define TINT_HSV\n",
+			"#define INSTANCED\n#define TEXTURED\n",
+			"#define INSTANCED\n#define SDF\n",
+			"#define INSTANCED\n#define ANIMATED\n",
+			"#define INSTANCED\n#define ANIMATED\n#define TEXTURED\n#define TINT_HSV\n",
+			"#define INSTANCED\n#define ANIMATED\n#define TEXTURED\n",
+			"#define INSTANCED\n#define ANIMATED\n#define SDF\n"
+		};
+
+		for (int i = 0; i < VariantCount; i++) {
+			Variant& v = variants[i];
+			v.id = compileShader(reinterpret_cast<const char*>(tile_vs), tile_vs_size, reinterpret_cast<const char*>(tile_fs), tile_fs_size, defines[i]);
+
+			if (v.id == 0) {
+				LOG_ERROR("GL", "Shader compilation failed for variant %d", i);
+				return false;
+			}
+
+			v.aPosLoc = glGetAttribLocation(v.id, "aPos");
+			v.aUvLoc = glGetAttribLocation(v.id, "aUv");
+			v.aRectLoc = glGetAttribLocation(v.id, "aRect");
+			v.aColorLoc = glGetAttribLocation(v.id, "aColor");
+			v.aColorHsvLoc = glGetAttribLocation(v.id, "aColorHsv");
+			v.aShapeLoc = glGetAttribLocation(v.id, "aShape");
+			v.aEventLoc = glGetAttribLocation(v.id, "aEvent");
+			v.aEventColorLoc = glGetAttribLocation(v.id, "aEventColor");
+			v.aLoopLoc = glGetAttribLocation(v.id, "aLoop");
+			v.aLoopColorLoc = glGetAttribLocation(v.id, "aLoopColor");
+
+			v.uMvpLoc = glGetUniformLocation(v.id, "uMvp");
+			v.uColorLoc = glGetUniformLocation(v.id, "uColor");
+			v.uColorHsvLoc = glGetUniformLocation(v.id, "uColorHsv");
+			v.uTextureLoc = glGetUniformLocation(v.id, "uTexture");
+			v.uShapeLoc = glGetUniformLocation(v.id, "uShape");
+			v.uTimeLoc = glGetUniformLocation(v.id, "uTime");
+
+			LOG_DEBUG("GL", "Shader %d Locs: %d %d / %d %d %d %d", i, v.aPosLoc, v.aUvLoc, v.uMvpLoc, v.uColorLoc, v.uColorHsvLoc, v.uTextureLoc);
+		}
+
+		return true;
+	}
+
+	bool TileShader::BindMesh(const Variant& v, const TileMesh& mesh) {
+		if (vao == 0) {
+			glGenVertexArrays(1, &vao);
+		}
+		glBindVertexArray(vao);
+
+		if (mesh.vertices == nullptr || !mesh.vertices->Bind()) {
+			LOG_ERROR("GL", "Failed to bind vertices");
+			return false;
+		}
+
+		// Attributes point at the start of the shared buffer, the mesh is selected by baseVertex
+		glEnableVertexAttribArray(v.aPosLoc);
+		glVertexAttribPointer(v.aPosLoc, 3, GL_FLOAT, false, sizeof(TileVertex), reinterpret_cast<const void*>(offsetof(TileVertex, x)));
+
+		if (v.aUvLoc >= 0) {
+			glEnableVertexAttribArray(v.aUvLoc);
+			glVertexAttribPointer(v.aUvLoc, 2, GL_FLOAT, false, sizeof(TileVertex), reinterpret_cast<const void*>(offsetof(TileVertex, u)));
+		}
+
+		if (mesh.indices == nullptr || !mesh.indices->Bind()) {
+			LOG_ERROR("GL", "Failed to bind indices");
+			UnbindMesh(v);
+			return false;
+		}
+
+		return true;
+	}
+
+	void TileShader::UnbindMesh(const Variant& v) {
+		if (v.aUvLoc >= 0) {
+			glDisableVertexAttribArray(v.aUvLoc);
+		}
+		glDisableVertexAttribArray(v.aPosLoc);
+	}
+
+	void TileShader::Draw(const TileMesh& mesh, const Texture* texture, glm::vec4 color, glm::mat4 mvp, TintMode tint, TileShape shape) {
+		TRACE_ZONE("TileShader::Draw");
+		bool shapes = shape != TileShape::None;
+		bool textured = !shapes && texture != nullptr && texture->Id() > 0;
+		const Variant& v = variants[VariantIndex(textured, tint, false, shapes)];
+		if (v.id == 0) {
+			return;
+		}
+
+		glUseProgram(v.id);
+
+		glUniformMatrix4fv(v.uMvpLoc, 1, GL_FALSE, glm::value_ptr(mvp));
+		glUniform4f(v.uColorLoc, color.r, color.g, color.b, color.a);
+
+		if (shapes) {
+			glUniform1i(v.uShapeLoc, static_cast<GLint>(shape));
+		} else if (textured) {
+			if (v.uColorHsvLoc >= 0) {
+				glm::vec3 hsv = rgbToHsv(glm::vec3(color.r, color.g, color.b));
+				glUniform3f(v.uColorHsvLoc, hsv.x, hsv.y, hsv.z);
+			}
+
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture->Id());
+			glUniform1i(v.uTextureLoc, 0);
+		}
+
+		if (!BindMesh(v, mesh)) {
+			return;
+		}
+
+		glDrawElementsBaseVertex(GL_TRIANGLES, mesh.amount, GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(mesh.indexOffset), mesh.baseVertex);
+
+		UnbindMesh(v);
+	}
+
+	void TileShader::DrawInstanced(const TileMesh& mesh, const Texture* texture, glm::mat4 vp, TintMode tint, Buffer<GL_ARRAY_BUFFER>& instances, GLuint firstInstance, GLsizei count,
+		bool shapes, Buffer<GL_ARRAY_BUFFER>* animations, float time) {
+		TRACE_ZONE("TileShader::DrawInstanced");
+		bool textured = !shapes && texture != nullptr && texture->Id() > 0;
+		const Variant& v = variants[VariantIndex(textured, tint, true, shapes, animations != nullptr)];
+		if (v.id == 0 || count <= 0) {
+			return;
+		}
+
+		glUseProgram(v.id);
+		glUniformMatrix4fv(v.uMvpLoc, 1, GL_FALSE, glm::value_ptr(vp));
+		if (animations != nullptr) {
+			glUniform1f(v.uTimeLoc, time);
+		}
+
+		if (textured) {
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, texture->Id());
+			glUniform1i(v.uTextureLoc, 0);
+		}
+
+		if (!BindMesh(v, mesh)) {
+			return;
+		}
+
+		if (!instances.Bind()) {
+			LOG_ERROR("GL", "Failed to bind instances");
+			UnbindMesh(v);
+			return;
+		}
+
+		// The instance attributes also point at the start of their buffer, the draw selects
+		// the range with baseInstance
+		const struct Attribute {
+			GLint location;
+			GLint components;
+			size_t offset;
+		} attributes[] = {
+			{ v.aRectLoc, 4, offsetof(TileInstance, x) },
+			{ v.aColorLoc, 4, offsetof(TileInstance, r) },
+			{ v.aColorHsvLoc, 4, offsetof(TileInstance, h) },
+			{ v.aShapeLoc, 1, offsetof(TileInstance, shape) }
+		}, animationAttributes[] = {
+			{ v.aEventLoc, 4, offsetof(TileAnimationInstance, event.start) },
+			{ v.aEventColorLoc, 4, offsetof(TileAnimationInstance, event.r) },
+			{ v.aLoopLoc, 4, offsetof(TileAnimationInstance, loop.start) },
+			{ v.aLoopColorLoc, 4, offsetof(TileAnimationInstance, loop.r) }
+		};
+
+		for (auto& a : attributes) {
+			if (a.location >= 0) {
+				glEnableVertexAttribArray(a.location);
+				glVertexAttribPointer(a.location, a.components, GL_FLOAT, false, sizeof(TileInstance), reinterpret_cast<const void*>(a.offset));
+				glVertexAttribDivisor(a.location, 1);
+			}
+		}
+
+		if (animations != nullptr && animations->Bind()) {
+			for (auto& a : animationAttributes) {
+				if (a.location >= 0) {
+					glEnableVertexAttribArray(a.location);
+					glVertexAttribPointer(a.location, a.components, GL_FLOAT, false, sizeof(TileAnimationInstance), reinterpret_cast<const void*>(a.offset));
+					glVertexAttribDivisor(a.location, 1);
+				}
+			}
+		}
+
+		glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mesh.amount, GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(mesh.indexOffset), count,
+			mesh.baseVertex, firstInstance);
+
+		// The VAO is shared with the non-instanced variants
+		for (auto& a : attributes) {
+			if (a.location >= 0) {
+				glVertexAttribDivisor(a.location, 0);
+				glDisableVertexAttribArray(a.location);
+			}
+		}
+		if (animations != nullptr) {
+			for (auto& a : animationAttributes) {
+				if (a.location >= 0) {
+					glVertexAttribDivisor(a.location, 0);
+					glDisableVertexAttribArray(a.location);
+				}
+			}
+		}
+		UnbindMesh(v);
+	}
+
+	TileShader::~TileShader() {
+		for (auto& v : variants) {
+			if (v.id != 0) {
+				LOG_DEBUG("GL", "Shader: deleting shader %u", v.id);
+				glDeleteProgram(v.id);
+				v.id = 0;
+			}
+		}
+
+		if (vao != 0) {
+			glDeleteVertexArrays(1, &vao);
+			vao = 0;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+#include "../fix_vscode.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "gl_buffer.hpp"
+#include "gl_texture.hpp"
+
+namespace gl {
+	// Compiles and links a vertex + fragment program. When defines is not null it is injected
+	// right after the #version line of both sources.
+	GLuint compileShader(const char* vs_source, size_t vs_length, const char* fs_source, size_t fs_length, const char* defines = nullptr);
+
+	// HSV of an RGB color, matching tile.fs' rgb2hsv
+	glm::vec3 rgbToHsv(glm::vec3 c);
+
+	// How a textured tile combines its texture with the tile color
+	enum class TintMode {
+		Hsv,		// Replace the texture hue with the color hue, scale saturation and value
+		Multiply	// Plain modulation, texture * color
+	};
+
+	// Shapes drawn analytically by the SDF variants, in place of the Base/Circle/Cross sprites.
+	// The values are shared with tile.fs.
+	enum class TileShape : uint8_t {
+		None = 0,		// Use the tile texture
+		Empty = 1,		// Just the rounded frame
+		Circle = 2,
+		Cross = 3
+	};
+
+	// Easing of a TileAnimation, the values are shared with tile.vs
+	enum class AnimationCurve : uint8_t {
+		None = 0,
+		EaseOut = 1,		// Cubic, from the target to the tile
+		EaseOutBack = 2,	// From the target to the tile, overshooting it first
+		Pulse = 3			// |sin|, from the tile to the target and back every duration, until stopped
+	};
+
+	// Interleaved vertex layout of tile meshes
+	struct TileVertex {
+		float x, y, z;
+		float u, v;
+	};
+
+	// Per-instance attributes of instanced tile draws
+	struct TileInstance {
+		float x, y;				// Center
+		float width, height;
+		float r, g, b, a;
+		float h, s, v;			// rgbToHsv(r, g, b), only read by the HSV tint
+		float depth;			// Added to the mesh z
+		float shape;			// TileShape, only read by the SDF variants
+	};
+
+	// Animation evaluated by the ANIMATED variants against the uTime uniform, so it costs
+	// nothing on the CPU once written
+	struct TileAnimation {
+		float start;			// uTime at which it starts
+		float duration;			// Seconds, the period of Pulse
+		float curve;			// AnimationCurve
+		float scale;			// Size multiplier at the target
+		float r, g, b, a;		// Color at the target
+
+		static TileAnimation Make(AnimationCurve curve, float start, float duration, float scale, glm::vec4 color) {
+			return TileAnimation { start, duration, static_cast<float>(curve), scale, color.r, color.g, color.b, color.a };
+		}
+		inline AnimationCurve Curve() const { return static_cast<AnimationCurve>(static_cast<int>(curve)); }
+		// False once a one-shot animation has settled back on the tile
+		inline bool IsActive(float time) const {
+			return Curve() == AnimationCurve::Pulse || (Curve() != AnimationCurve::None && time < start + duration);
+		}
+	};
+
+	// Per-instance animations of the ANIMATED variants, the loop is applied on top of the event
+	struct TileAnimationInstance {
+		TileAnimation event;	// One-shot, e.g. a placement
+		TileAnimation loop;		// Repeating, e.g. the selection pulse
+	};
+
+	// A tile mesh inside shared buffers: vertices start at baseVertex in the vertex buffer,
+	// amount 16-bit indices start at indexOffset bytes in the index buffer
+	struct TileMesh {
+		Buffer<GL_ARRAY_BUFFER>* vertices;
+		Buffer<GL_ELEMENT_ARRAY_BUFFER>* indices;
+		GLint baseVertex;
+		GLintptr indexOffset;
+		GLint amount;
+	};
+
+	class TileShader {
+	protected:
+		// A single #define-specialized permutation of tile.vs/tile.fs
+		struct Variant {
+			GLuint id;
+
+			GLint aPosLoc, aUvLoc;
+			GLint aRectLoc, aColorLoc, aColorHsvLoc, aShapeLoc;
+			GLint aEventLoc, aEventColorLoc, aLoopLoc, aLoopColorLoc;
+			GLint uMvpLoc;
+			GLint uColorLoc;
+			GLint uColorHsvLoc;
+			GLint uTextureLoc;
+			GLint uShapeLoc;
+			GLint uTimeLoc;
+		};
+
+		// [0] untextured, [1] textured + hsv tint, [2] textured + multiply tint, [3] SDF shapes,
+		// then the same four again with INSTANCED, and again with INSTANCED + ANIMATED
+		static constexpr int VariantCount = 12;
+
+		Variant variants[VariantCount];
+		GLuint vao;
+
+		static int VariantIndex(bool textured, TintMode tint, bool instanced = false, bool shapes = false, bool animated = false);
+		// Binds the mesh buffers and enables the per-vertex attributes, false on failure
+		bool BindMesh(const Variant& v, const TileMesh& mesh);
+		void UnbindMesh(const Variant& v);
+	public:
+		TileShader();
+		TileShader(const TileShader&) = delete;
+
+		TileShader& operator=(const TileShader&) = delete;
+
+		bool Load();
+
+		// With a shape other than None the tile is drawn with the SDF variant and texture and
+		// tint are ignored
+		void Draw(const TileMesh& mesh, const Texture* texture, glm::vec4 color, glm::mat4 mvp, TintMode tint = TintMode::Hsv, TileShape shape = TileShape::None);
+		// Draws count copies of mesh, one per TileInstance of instances starting at firstInstance.
+		// vp is the view-projection, placement and color come from the instances. With shapes
+		// the instance shapes are drawn with the SDF variant instead of texture.
+		// With animations (one TileAnimationInstance per TileInstance, same indices) the tiles
+		// are animated on the GPU as of time.
+		void DrawInstanced(const TileMesh& mesh, const Texture* texture, glm::mat4 vp, TintMode tint, Buffer<GL_ARRAY_BUFFER>& instances, GLuint firstInstance, GLsizei count,
+			bool shapes = false, Buffer<GL_ARRAY_BUFFER>* animations = nullptr, float time = 0.0f);
+
+		~TileShader();
+	};
+}
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
 #include <chrono>
 
 // Include the main libnx system header, for Switch development
@@ -15,9 +16,24 @@
 #include <EGL/eglext.h> // EGL extensions
 #include <glad/glad.h> // OpenGL loader
 
+#include "core/log.hpp"
+#include "core/trace.hpp"
+#include "core/frame_scheduler.hpp"
+#include "core/input.hpp"
+#include "core/memory_stats.hpp"
+#include "core/resolution_controller.hpp"
+#include "core/job_system.hpp"
 #include "ttt/solver.hpp"
+#include "ttt/search.hpp"
+#include "ttt/analysis.hpp"
+#include "ttt/ponder.hpp"
+#include "ttt/spectator.hpp"
 #include "gl/tile_renderer.hpp"
+#include "gl/text_renderer.hpp"
+#include "gl/tile_batch.hpp"
+#include "gl/gpu_timer.hpp"
 #include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
 #include "Base_png.h"
 #include "Cross_png.h"
 #include "Circle_png.h"
@@ -27,6 +43,52 @@ constexpr glm::vec4 crossColor(1.0f, 0.0f, 0.0f, 1.0f);
 constexpr glm::vec4 circleColor(0.0f, 0.0f, 1.0f, 1.0f);
 constexpr glm::vec4 emptyColor(1.0f, 1.0f, 1.0f, 1.0f);
 constexpr glm::vec4 errorColor(0.0f, 0.0f, 0.0f, 1.0f);
+constexpr glm::vec4 winColor(0.3f, 1.0f, 0.3f, 1.0f);
+constexpr glm::vec4 drawColor(0.8f, 0.8f, 0.8f, 1.0f);
+constexpr glm::vec4 lossColor(1.0f, 0.4f, 0.4f, 1.0f);
+constexpr glm::vec4 unknownColor(0.5f, 0.5f, 0.5f, 1.0f);
+constexpr glm::vec4 winLineColor(1.0f, 1.0f, 0.6f, 1.0f);
+
+// Tile animations, started on game events and evaluated on the GPU from then on
+gl::TileAnimation PlacementAnimation(float start) {
+	return gl::TileAnimation::Make(gl::AnimationCurve::EaseOutBack, start, 0.35f, 0.3f, glm::vec4(1.0f));
+}
+
+gl::TileAnimation WinLineAnimation(float start) {
+	return gl::TileAnimation::Make(gl::AnimationCurve::Pulse, start, 0.8f, 1.1f, winLineColor);
+}
+
+gl::TileAnimation ResetAnimation(float start) {
+	return gl::TileAnimation::Make(gl::AnimationCurve::EaseOut, start, 0.3f, 0.5f, glm::vec4(emptyColor.r, emptyColor.g, emptyColor.b, 0.0f));
+}
+
+// Cells of the completed line of a won 3x3 board, false when there is none
+bool FindWinLine(const ttt::Board& board, ttt::Coord line[3]) {
+	// Start cell and direction of every line
+	static const int lines[8][4] = {
+		{ 0, 0, 1, 0 }, { 0, 1, 1, 0 }, { 0, 2, 1, 0 },
+		{ 0, 0, 0, 1 }, { 1, 0, 0, 1 }, { 2, 0, 0, 1 },
+		{ 0, 0, 1, 1 }, { 0, 2, 1, -1 }
+	};
+
+	for (auto& l : lines) {
+		ttt::TileState first = board.Get(l[0], l[1]);
+		if (first != ttt::TileState::Circle && first != ttt::TileState::Cross) {
+			continue;
+		}
+
+		bool complete = true;
+		for (int i = 0; i < 3 && complete; i++) {
+			line[i] = ttt::Coord { static_cast<unsigned int>(l[0] + l[2] * i), static_cast<unsigned int>(l[1] + l[3] * i) };
+			complete = board.Get(line[i]) == first;
+		}
+		if (complete) {
+			return true;
+		}
+	}
+
+	return false;
+}
 
 EGLDisplay egl_display;
 EGLContext egl_context;
@@ -98,7 +160,7 @@ int InitEGL(NWindow* win) {
 }
 
 void glDebugCB(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
-	std::string src = "[SRC_UNKNOWN]";
+	const char* src = "[SRC_UNKNOWN]";
 	switch(source) {
 		case GL_DEBUG_SOURCE_API:
 			src = "[SRC_API]";
@@ -120,10 +182,10 @@ void glDebugCB(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei l
 			break;
 	}
 
-	std::string tp = "[TYPE_UNKNOWN]";
+	const char* tp = "[TYPE_UNKNOWN]";
 	switch(type) {
 		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-			tp = "[TYPE_DEPRECATED";
+			tp = "[TYPE_DEPRECATED]";
 			break;
 		case GL_DEBUG_TYPE_ERROR:
 			tp = "[TYPE_ERROR]";
@@ -151,23 +213,39 @@ void glDebugCB(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei l
 			break;
 	}
 
-	std::string sev = "[SEV_UNKNOWN]";
+	core::LogLevel level = core::LogLevel::Debug;
 	switch(severity) {
 		case GL_DEBUG_SEVERITY_HIGH:
-			sev = "[SEV_HIGH]";
-			break;
-		case GL_DEBUG_SEVERITY_LOW:
-			sev = "[SEV_LOW]";
+			level = core::LogLevel::Error;
 			break;
 		case GL_DEBUG_SEVERITY_MEDIUM:
-			sev = "[SEV_MEDIUM]";
+			level = core::LogLevel::Warning;
+			break;
+		case GL_DEBUG_SEVERITY_LOW:
+			level = core::LogLevel::Info;
 			break;
 		case GL_DEBUG_SEVERITY_NOTIFICATION:
-			sev = "[SEV_NOTIF]";
+			level = core::LogLevel::Debug;
 			break;
 	}
 
-	std::cout << "[GLD]" << sev << tp << src << ": " << std::string(message, length) << std::endl;
+	if (length < 0) {
+		length = static_cast<GLsizei>(strlen(message));
+	}
+
+	// Driver messages are often longer than a log record, the rest of the text goes into
+	// continuation records instead of being cut off
+	constexpr int recordLength = static_cast<int>(core::LogRecord::MessageCapacity) - 1;
+	int firstLength = std::max(1, recordLength - static_cast<int>(strlen(tp) + strlen(src) + 2));
+	int chunkLength = recordLength - 2;
+
+	int offset = std::min(static_cast<int>(length), firstLength);
+	LOG_AT(level, "GLD", "%s%s: %.*s", tp, src, offset, message);
+	while (offset < length) {
+		int chunk = std::min(static_cast<int>(length) - offset, chunkLength);
+		LOG_AT(level, "GLD", "  %.*s", chunk, message + offset);
+		offset += chunk;
+	}
 }
 
 void CleanupEGL() {
@@ -214,6 +292,74 @@ void setMesaConfig() {
 #endif
 }
 
+// GPU time the scene may take per frame at the given swap interval, the rest of the vblank
+// period is left for the upscale, the overlay and the compositor
+double SceneBudgetMs(int swapInterval) {
+	return 0.8 * 1000.0 / 60.0 * (swapInterval > 0 ? swapInterval : 1);
+}
+
+// Output resolution of the default window in the given operation mode
+glm::ivec2 WindowSize(AppletOperationMode mode) {
+	return mode == AppletOperationMode_Console ? glm::ivec2(1920, 1080) : glm::ivec2(1280, 720);
+}
+
+// Lays the wall out as a grid of boards filling the screen and queues every tile into batch,
+// as SDF shapes or, without shapes, as sprites
+void DrawWall(gl::TileBatch& batch, const ttt::SpectatorWall& wall, glm::ivec2 screenSize, bool shapes, gl::TextureHandle circle, gl::TextureHandle cross, gl::TextureHandle empty) {
+	TRACE_ZONE("DrawWall");
+	unsigned int count = wall.Count();
+	if (count == 0) {
+		return;
+	}
+
+	unsigned int columns = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<float>(count) * screenSize.x / screenSize.y)));
+	unsigned int rows = (count + columns - 1) / columns;
+	float cell = glm::min(static_cast<float>(screenSize.x) / columns, static_cast<float>(screenSize.y) / rows);
+	float tile = cell * 0.9f / 3.0f;
+	glm::vec2 origin(-cell * columns / 2.0f, cell * rows / 2.0f);
+
+	for (unsigned int i = 0; i < count; i++) {
+		const ttt::Board& board = wall.Get(i);
+		glm::vec2 center = origin + glm::vec2((i % columns + 0.5f) * cell, -(i / columns + 0.5f) * cell);
+		bool finished = board.GetState() != ttt::BoardState::Regular;
+
+		for (unsigned int y = 0; y < 3; y++) {
+			for (unsigned int x = 0; x < 3; x++) {
+				gl::TextureHandle texture = empty;
+				gl::TileShape shape = gl::TileShape::Empty;
+				glm::vec4 color = emptyColor;
+				switch (board.Get(x, y)) {
+				case ttt::TileState::Circle:
+					texture = circle;
+					shape = gl::TileShape::Circle;
+					color = circleColor;
+					break;
+				case ttt::TileState::Cross:
+					texture = cross;
+					shape = gl::TileShape::Cross;
+					color = crossColor;
+					break;
+				default:
+					break;
+				}
+				if (finished) {
+					color.a = 0.5f;
+				}
+
+				glm::vec3 position(center.x + (static_cast<float>(x) - 1.0f) * tile, center.y + (static_cast<float>(y) - 1.0f) * tile, -1.0f);
+				if (shapes) {
+					batch.Add(shape, position, glm::vec2(tile), color);
+				} else {
+					batch.Add(texture, position, glm::vec2(tile), color);
+				}
+			}
+		}
+	}
+
+	glm::mat4 vp = glm::ortho(-screenSize.x / 2.0f, screenSize.x / 2.0f, -screenSize.y / 2.0f, screenSize.y / 2.0f, 0.1f, 100.0f);
+	batch.Draw(vp);
+}
+
 // Main program entrypoint
 int main(int argc, char* argv[])
 {
@@ -222,14 +368,17 @@ int main(int argc, char* argv[])
 	// Configure our supported input layout: a single player with standard controller styles
 	padConfigureInput(1, HidNpadStyleSet_NpadStandard);
 
-	// Initialize the default gamepad (which reads handheld mode inputs as well as the first connected controller)
-	PadState pad;
-	padInitializeDefault(&pad);
-
 #ifdef DEBUG
 	socketInitializeDefault();
 	nxlinkStdio();
 #endif
+	core::LogStart();
+
+	// The default gamepad (handheld mode inputs as well as the first connected controller) is
+	// polled on its own thread, the main loop only drains its button edges
+	core::InputPoller input;
+	core::InputLatency inputLatency;
+	input.Start();
 
 	// Other initialization goes here. As a demonstration, we print hello world.
 	printf("Hello World!\n");
@@ -246,20 +395,73 @@ int main(int argc, char* argv[])
 		glDebugMessageCallback(glDebugCB, nullptr);
 #endif
 
-		auto last_frame = std::chrono::high_resolution_clock::now();
-
 		// Main loop
 
+		// The window follows the docked/handheld output resolution, the scene is rendered
+		// offscreen at a fraction of it picked from the measured GPU time and upscaled on present
+		AppletOperationMode operationMode = appletGetOperationMode();
+		glm::ivec2 windowSize = WindowSize(operationMode);
+		nwindowSetDimensions(nwindowGetDefault(), windowSize.x, windowSize.y);
 		u32 width;
 		u32 height;
 		nwindowGetDimensions(nwindowGetDefault(), &width, &height);
+		LOG_INFO("MAIN", "Output resolution: %ux%u", width, height);
 
 		glViewport(0, 0, width, height);
 		glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
-		float totalTime = 0;
-		float waitStart = 0;
+		// Simulation state, advanced in fixed steps by the scheduler
+		core::FrameScheduler scheduler;
+		double waitStart = 0;
 		bool waiting = false;
-		int aiTurn = 0;
+		ttt::Difficulty difficulty = ttt::Difficulty::Hard;
+
+		// Pacing modes L cycles through, unlocked first capped at twice the display rate
+		// and then uncapped
+		struct PacingMode {
+			core::FramePacing pacing;
+			double frameRate;
+		};
+		static const PacingMode pacingModes[] = {
+			{ core::FramePacing::Vsync60, 0.0 },
+			{ core::FramePacing::Vsync30, 0.0 },
+			{ core::FramePacing::Unlocked, 120.0 },
+			{ core::FramePacing::Unlocked, 0.0 }
+		};
+		unsigned int pacingIndex = 0;
+
+		// Stats overlay, the FPS line is refreshed twice a second so its layout stays cached
+		static const char* const difficultyNames[] = { "Easy", "Medium", "Hard", "Perfect" };
+		char statsText[160] = "";
+		double statsTime = 0;
+		unsigned int statsFrames = 0;
+		char aiText[96] = "";
+		char analysisText[96] = "";
+
+		// Worker threads on the other two cores, shared by the pondering AI and the spectator wall
+		core::JobSystem jobs;
+
+		// Analysis mode shows the value of every empty cell for the player. Values are cached
+		// per position, so only a board change costs a search.
+		bool analysisMode = false;
+		const ttt::PositionAnalysis* analysis = nullptr;
+		std::shared_ptr<ttt::Analyzer> analyzer = std::make_shared<ttt::Analyzer>();
+
+		// The AI searches its replies on the job system while the player is to move, restarted
+		// whenever the position or the difficulty changes
+		std::shared_ptr<ttt::Ponderer> ponderer = std::make_shared<ttt::Ponderer>(jobs);
+		bool ponderDirty = true;
+
+		// Spectator wall: many AI-vs-AI games drawn at once through the instanced tile batch,
+		// ZR grows the wall to benchmark the draw path. Its games are stepped on the job system.
+		static const unsigned int wallSizes[] = { 16, 64, 256, 1024 };
+		bool wallMode = false;
+		unsigned int wallSizeIndex = 1;
+		ttt::SpectatorWall wall(wallSizes[wallSizeIndex]);
+		char wallText[128] = "";
+		uint64_t wallGamesAtStats = 0;
+
+		eglSwapInterval(egl_display, scheduler.SwapInterval());
+		core::ResolutionController resolution(SceneBudgetMs(scheduler.SwapInterval()));
 
 		ttt::Coord selectedCoord{ 1, 1 };
 		ttt::Board board;
@@ -271,136 +473,386 @@ int main(int argc, char* argv[])
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-		std::shared_ptr<gl::TileRenderer> render = std::make_shared<gl::TileRenderer>();
-		std::shared_ptr<gl::Texture> cross_texture = std::make_shared<gl::Texture>();
-		cross_texture->LoadPNG(Cross_png, Cross_png_size);
-		std::shared_ptr<gl::Texture> circle_texture = std::make_shared<gl::Texture>();
-		circle_texture->LoadPNG(Circle_png, Circle_png_size);
-		std::shared_ptr<gl::Texture> empty_texture = std::make_shared<gl::Texture>();
-		empty_texture->LoadPNG(Base_png, Base_png_size);
+		// Asset memory budgets, a warning is logged by the load that crosses one
+		core::MemorySetTotalBudget(64 * 1024 * 1024);
+		core::MemorySetBudget(core::MemoryCategory::DecodeScratch, 16 * 1024 * 1024);
+
+		std::shared_ptr<gl::Resources> resources = std::make_shared<gl::Resources>();
+		std::shared_ptr<gl::TileRenderer> render = std::make_shared<gl::TileRenderer>(*resources);
+		std::shared_ptr<gl::TextRenderer> text = std::make_shared<gl::TextRenderer>(*resources);
+		std::shared_ptr<gl::TileBatch> batch = std::make_shared<gl::TileBatch>(*resources);
+		std::shared_ptr<gl::GpuTimer> gpuTimer = std::make_shared<gl::GpuTimer>();
+		gl::FramebufferHandle sceneTarget = resources->framebuffers.Create();
+		// Tiles are drawn as SDF shapes, ZL switches to the sprite textures, which are only
+		// loaded the first time they are needed
+		bool sdfTiles = true;
+		gl::TextureHandle cross_texture;
+		gl::TextureHandle circle_texture;
+		gl::TextureHandle empty_texture;
 		while (appletMainLoop())
 		{
 
-			// Scan the gamepad. This should be done once for each frame
-			padUpdate(&pad);
-
-			// padGetButtonsDown returns the set of buttons that have been
-			// newly pressed in this frame compared to the previous one
-			u64 kDown = padGetButtonsDown(&pad);
+			TRACE_FRAME();
+
+			u64 kDown = 0;
+			{
+				TRACE_ZONE("Input");
+				// Every button newly pressed since the last frame
+				core::InputEvent event;
+				while (input.Poll(event)) {
+					if (event.type == core::InputEventType::Down) {
+						kDown |= event.buttons;
+						inputLatency.Handled(event);
+					}
+				}
+			}
 
 			if (kDown & HidNpadButton_Plus)
 				break; // break in order to return to hbmenu
 
-			// Your code goes here
+			if (kDown & HidNpadButton_Minus) {
+				TRACE_EXPORT("sdmc:/SwitchHBTest_trace.json");
+				LOG_INFO("INPUT", "Input to present: avg %.2f ms, max %.2f ms over %llu presses", inputLatency.AverageMs(), inputLatency.MaxMs(),
+					static_cast<unsigned long long>(inputLatency.Samples()));
+				inputLatency.Reset();
+				core::MemoryLogSnapshot();
+			}
 
-			auto now = std::chrono::high_resolution_clock::now();
-			auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_frame).count() / 1000.0f;
-			last_frame = now;
-			totalTime += delta;
-			
-			float selectionOverlayAmount = glm::abs(glm::sin(totalTime * 3));
+			if (kDown & HidNpadButton_L) {
+				pacingIndex = (pacingIndex + 1) % (sizeof(pacingModes) / sizeof(pacingModes[0]));
+				scheduler.SetPacing(pacingModes[pacingIndex].pacing);
+				scheduler.SetTargetFrameRate(pacingModes[pacingIndex].frameRate);
+				eglSwapInterval(egl_display, scheduler.SwapInterval());
+				resolution.SetTarget(SceneBudgetMs(scheduler.SwapInterval()));
+				LOG_INFO("MAIN", "Swap interval: %d, frame rate cap: %.0f", scheduler.SwapInterval(), pacingModes[pacingIndex].frameRate);
+			}
+
+			if (kDown & HidNpadButton_R) {
+				difficulty = static_cast<ttt::Difficulty>((static_cast<int>(difficulty) + 1) % (static_cast<int>(ttt::Difficulty::Perfect) + 1));
+				LOG_INFO("MAIN", "AI difficulty: %d", static_cast<int>(difficulty));
+				ponderDirty = true;
+			}
+
+			if (kDown & HidNpadButton_Y) {
+				analysisMode = !analysisMode;
+				LOG_INFO("MAIN", "Analysis mode: %s", analysisMode ? "on" : "off");
+			}
+
+			if (kDown & HidNpadButton_X) {
+				wallMode = !wallMode;
+				LOG_INFO("MAIN", "Spectator wall: %s", wallMode ? "on" : "off");
+				// The wall simulation gets the CPU, pondering resumes on the way back
+				if (wallMode) {
+					ponderer->Stop();
+				}
+				ponderDirty = true;
+			}
+
+			if (wallMode && (kDown & HidNpadButton_ZR)) {
+				LOG_INFO("MAIN", "Spectator wall: %s", wallText);
+				wallSizeIndex = (wallSizeIndex + 1) % (sizeof(wallSizes) / sizeof(wallSizes[0]));
+				wall.Resize(wallSizes[wallSizeIndex]);
+			}
+
+			if (kDown & HidNpadButton_ZL) {
+				sdfTiles = !sdfTiles;
+				LOG_INFO("MAIN", "Tiles: %s", sdfTiles ? "SDF shapes" : "sprites");
+				if (!sdfTiles && !empty_texture.IsValid()) {
+					cross_texture = resources->LoadPNG(Cross_png, Cross_png_size);
+					circle_texture = resources->LoadPNG(Circle_png, Circle_png_size);
+					empty_texture = resources->LoadPNG(Base_png, Base_png_size);
+				}
+			}
+
+			if (appletGetOperationMode() != operationMode) {
+				// Docked or undocked: resize the window, the scene target follows on its next
+				// Allocate and the tile layout on the next TileRenderer::Draw
+				operationMode = appletGetOperationMode();
+				windowSize = WindowSize(operationMode);
+				nwindowSetDimensions(nwindowGetDefault(), windowSize.x, windowSize.y);
+				nwindowGetDimensions(nwindowGetDefault(), &width, &height);
+				resolution.Reset();
+				LOG_INFO("MAIN", "Output resolution: %ux%u", width, height);
+			}
+
+			unsigned int steps = scheduler.BeginFrame();
+			// Animations run on the simulation clock, interpolated like the rest of the frame
+			float animationTime = static_cast<float>(scheduler.SimulationTime() - scheduler.FixedStep() * (1.0 - scheduler.Alpha()));
 
 			int xMov = 0;
 			int yMov = 0;
 			bool applyClick = false;
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			
-			if (!waiting) {
-				if (kDown & HidNpadButton_AnyRight) {
-					xMov++;
-				}
 
-				if (kDown & HidNpadButton_AnyLeft) {
-					xMov--;
-				}
+			{
+				TRACE_ZONE("Update");
+				if (!waiting && !wallMode) {
+					if (kDown & HidNpadButton_AnyRight) {
+						xMov++;
+					}
 
-				if (kDown & HidNpadButton_AnyUp) {
-					yMov++;
-				}
+					if (kDown & HidNpadButton_AnyLeft) {
+						xMov--;
+					}
 
-				if (kDown & HidNpadButton_AnyDown) {
-					yMov--;
-				}
+					if (kDown & HidNpadButton_AnyUp) {
+						yMov++;
+					}
 
-				if (kDown & HidNpadButton_A) {
-					applyClick = true;
-				}
+					if (kDown & HidNpadButton_AnyDown) {
+						yMov--;
+					}
 
-				selectedCoord.x += xMov;
-				selectedCoord.y += yMov;
-				selectedCoord.Normalize();
+					if (kDown & HidNpadButton_A) {
+						applyClick = true;
+					}
 
-				if (applyClick) {
-					if(board.Set(selectedCoord, ttt::TileState::Circle)) {
-						if (board.GetState() != ttt::BoardState::Regular) {
-							waitStart = totalTime;
-							waiting = true;
+					selectedCoord.x += xMov;
+					selectedCoord.y += yMov;
+					selectedCoord.Normalize(board.Size());
+
+					if (applyClick) {
+						if(board.Set(selectedCoord, ttt::TileState::Circle)) {
+							float now = animationTime;
+							render->Animate(selectedCoord.x, selectedCoord.y, gl::AnimationTrack::Event, PlacementAnimation(now));
+							if (board.GetState() == ttt::BoardState::Regular) {
+								bool pondered = false;
+								ttt::SearchResult aiMove = ponderer->Reply(board, pondered);
+								if (aiMove.valid) {
+									board.Set(aiMove.move, ttt::TileState::Cross);
+									render->Animate(aiMove.move.x, aiMove.move.y, gl::AnimationTrack::Event, PlacementAnimation(now + 0.2f));
+									LOG_DEBUG("AI", "Move %u,%u score %d depth %u nodes %llu%s%s", aiMove.move.x, aiMove.move.y, aiMove.score, aiMove.depth,
+										static_cast<unsigned long long>(aiMove.nodes), aiMove.random ? " (random)" : "", pondered ? " (pondered)" : "");
+									snprintf(aiText, sizeof(aiText), "AI depth %u, %llu nodes%s%s", aiMove.depth,
+										static_cast<unsigned long long>(aiMove.nodes), aiMove.random ? " (random)" : "", pondered ? " (pondered)" : "");
+								}
+							}
+							ponderDirty = true;
+
+							if (board.GetState() != ttt::BoardState::Regular) {
+								waitStart = animationTime;
+								waiting = true;
+
+								render->ClearSelection();
+								ttt::Coord line[3];
+								if (FindWinLine(board, line)) {
+									for (int i = 0; i < 3; i++) {
+										render->Animate(line[i].x, line[i].y, gl::AnimationTrack::Loop, WinLineAnimation(now + 0.4f + i * 0.1f));
+									}
+								}
+							}
 						}
+					}
+				}
+
+				for (unsigned int i = 0; i < steps; i++) {
+					double stepTime = scheduler.SimulationTime() - scheduler.FixedStep() * (steps - 1 - i);
 
-						ttt::NextMove(board, aiTurn++);
+					if (waiting && stepTime - waitStart > 5) {
+						board.Reset();
+						waiting = false;
+						ponderDirty = true;
 
-						if (board.GetState() != ttt::BoardState::Regular) {
-							waitStart = totalTime;
-							waiting = true;
+						for (unsigned int x = 0; x < 3; x++) {
+							for (unsigned int y = 0; y < 3; y++) {
+								render->StopAnimation(x, y, gl::AnimationTrack::Loop);
+								render->Animate(x, y, gl::AnimationTrack::Event, ResetAnimation(static_cast<float>(stepTime) + (x + y) * 0.05f));
+							}
 						}
 					}
+
+					if (wallMode) {
+						wall.Step(&jobs);
+					}
 				}
-			} else {
-				if (totalTime - waitStart > 5) {
-					board.Reset();
-					waiting = false;
-					aiTurn = 0;
+
+				if (ponderDirty && !waiting && !wallMode) {
+					ponderer->Start(board, ttt::TileState::Cross, ttt::LimitsFor(difficulty), static_cast<uint32_t>(scheduler.FrameIndex()));
+					ponderDirty = false;
 				}
 			}
 
-			for(unsigned int x = 0; x < 3; x++) {
-				for(unsigned int y = 0; y < 3; y++) {
-					gl::Tile* t = render->Get(x, y);
-					ttt::TileState state = board.Get(x, y);
-					if (t == nullptr)
-						continue;
-
-					glm::vec4 baseColor = emptyColor;
-					switch(state) {
-					case ttt::TileState::Circle:
-						baseColor = circleColor;
-						t->texture = circle_texture;
-						break;
-					case ttt::TileState::Cross:
-						baseColor = crossColor;
-						t->texture = cross_texture;
-						break;
-					case ttt::TileState::Empty:
-						baseColor = emptyColor;
-						t->texture = empty_texture;
-						break;
-					case ttt::TileState::Invalid:
-						baseColor = errorColor;
-						t->texture = empty_texture;
-						break;
-					}
+			analysis = nullptr;
+			if (analysisMode && !wallMode && board.GetState() == ttt::BoardState::Regular) {
+				TRACE_ZONE("Analysis");
+				// Unfinished analyses (larger boards) continue over the next frames
+				analysis = &analyzer->Analyze(board, ttt::TileState::Circle, std::chrono::milliseconds(4));
+				snprintf(analysisText, sizeof(analysisText), "Analysis %s, %llu nodes", analysis->complete ? "done" : "running",
+					static_cast<unsigned long long>(analysis->nodes));
+			}
 
-					if (selectedCoord.x == x && selectedCoord.y == y) {
-						baseColor = glm::mix(baseColor, selectionColor, selectionOverlayAmount);
-					}
+			glm::ivec2 screenSize(width, height);
+			glm::ivec2 renderSize = glm::max(glm::ivec2(glm::vec2(screenSize) * resolution.Scale() + 0.5f), glm::ivec2(1));
+			gl::Framebuffer* scene = resources->framebuffers.Get(sceneTarget);
+			bool offscreen = scene != nullptr && scene->Allocate(screenSize) && scene->Bind(renderSize);
+			if (!offscreen) {
+				gl::Framebuffer::BindDefault(screenSize);
+				renderSize = screenSize;
+			}
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			gpuTimer->Begin();
 
-					t->color = baseColor;
+			// Layouts and projections stay in window pixels, only the viewport is scaled
+			if (wallMode) {
+				DrawWall(*batch, wall, glm::ivec2(width, height), sdfTiles, circle_texture, cross_texture, empty_texture);
+			} else {
+				{
+					TRACE_ZONE("UpdateTiles");
+					for(unsigned int x = 0; x < 3; x++) {
+						for(unsigned int y = 0; y < 3; y++) {
+							gl::Tile* t = render->Get(x, y);
+							ttt::TileState state = board.Get(x, y);
+							if (t == nullptr)
+								continue;
+
+							glm::vec4 baseColor = emptyColor;
+							gl::TileShape shape = gl::TileShape::Empty;
+							switch(state) {
+							case ttt::TileState::Circle:
+								baseColor = circleColor;
+								shape = gl::TileShape::Circle;
+								t->texture = circle_texture;
+								break;
+							case ttt::TileState::Cross:
+								baseColor = crossColor;
+								shape = gl::TileShape::Cross;
+								t->texture = cross_texture;
+								break;
+							case ttt::TileState::Empty:
+								baseColor = emptyColor;
+								t->texture = empty_texture;
+								if (analysis != nullptr) {
+									switch (analysis->At(x, y).outcome) {
+									case ttt::MoveOutcome::Win:
+										baseColor = winColor;
+										break;
+									case ttt::MoveOutcome::Draw:
+										baseColor = drawColor;
+										break;
+									case ttt::MoveOutcome::Loss:
+										baseColor = lossColor;
+										break;
+									default:
+										baseColor = unknownColor;
+										break;
+									}
+								}
+								break;
+							case ttt::TileState::Invalid:
+								baseColor = errorColor;
+								t->texture = empty_texture;
+								break;
+							}
+
+							t->color = baseColor;
+							t->shape = sdfTiles ? shape : gl::TileShape::None;
+						}
+					}
+					if (!waiting) {
+						render->SetSelection(selectedCoord.x, selectedCoord.y, selectionColor, animationTime);
+					}
 				}
+
+				render->Draw(glm::ivec2(width, height), 10, animationTime);
 			}
 
-			render->Draw(glm::ivec2(width, height), 10);
+			gpuTimer->End();
+			if (offscreen) {
+				TRACE_ZONE("Upscale");
+				scene->BlitToDefault(renderSize, screenSize);
+			}
+			if (gpuTimer->Poll()) {
+				resolution.Update(gpuTimer->LastMs());
+			}
 
-			eglSwapBuffers(egl_display, egl_surface);
+			statsFrames++;
+			statsTime += scheduler.FrameDelta();
+			if (statsTime >= 0.5) {
+				snprintf(statsText, sizeof(statsText), "%.1f FPS (%.2f ms)\nInput %.1f ms avg, %.1f ms max\nRender %dx%d (%.0f%%), GPU %.2f ms", statsFrames / statsTime,
+					statsTime * 1000.0 / statsFrames, inputLatency.AverageMs(), inputLatency.MaxMs(), renderSize.x, renderSize.y, resolution.Scale() * 100.0f, gpuTimer->LastMs());
+				snprintf(wallText, sizeof(wallText), "Wall %u boards: %u tiles, %u draw calls, %.2f ms/frame, %.1f games/s", wall.Count(),
+					batch->LastStats().instances, batch->LastStats().drawCalls, statsTime * 1000.0 / statsFrames, (wall.GamesFinished() - wallGamesAtStats) / statsTime);
+				wallGamesAtStats = wall.GamesFinished();
+				statsFrames = 0;
+				statsTime = 0;
+			}
+			text->Add(statsText, glm::vec2(16, 16));
+			if (wallMode) {
+				text->Add(wallText, glm::vec2(16, 72), 2.0f, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
+			} else {
+				text->Add(difficultyNames[static_cast<int>(difficulty)], glm::vec2(16, 72), 2.0f, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
+				text->Add(aiText, glm::vec2(16, 92));
+			}
+			if (analysis != nullptr) {
+				text->Add(analysisText, glm::vec2(16, 112));
+
+				// Outcome and plies to the end, centered on every empty cell
+				for (unsigned int x = 0; x < 3; x++) {
+					for (unsigned int y = 0; y < 3; y++) {
+						const ttt::MoveValue& value = analysis->At(x, y);
+						gl::Tile* t = render->Get(x, y);
+						if (t == nullptr || value.outcome == ttt::MoveOutcome::None) {
+							continue;
+						}
+
+						char label[8];
+						switch (value.outcome) {
+						case ttt::MoveOutcome::Win:
+							snprintf(label, sizeof(label), "W%u", value.distance);
+							break;
+						case ttt::MoveOutcome::Draw:
+							snprintf(label, sizeof(label), "D%u", value.distance);
+							break;
+						case ttt::MoveOutcome::Loss:
+							snprintf(label, sizeof(label), "L%u", value.distance);
+							break;
+						default:
+							snprintf(label, sizeof(label), "?");
+							break;
+						}
+
+						glm::vec2 extent = text->Measure(label, 4.0f);
+						glm::vec2 center(width / 2.0f + t->position.x, height / 2.0f - t->position.y);
+						text->Add(label, center - extent / 2.0f, 4.0f, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+					}
+				}
+			}
+			text->Draw(glm::ivec2(width, height));
+
+			{
+				TRACE_ZONE("Swap");
+				eglSwapBuffers(egl_display, egl_surface);
+			}
+			inputLatency.Presented();
+			resources->EndFrame();
+			scheduler.EndFrame();
 		}
 
-		circle_texture = nullptr;
-		cross_texture = nullptr;
-		empty_texture = nullptr;
+		core::MemoryLogSnapshot();
+
+		LOG_INFO("MAIN", "Analysis cache: %llu hits, %llu misses", static_cast<unsigned long long>(analyzer->Hits()),
+			static_cast<unsigned long long>(analyzer->Misses()));
+
+		LOG_INFO("MAIN", "Pondered replies: %llu hits, %llu misses", static_cast<unsigned long long>(ponderer->Hits()),
+			static_cast<unsigned long long>(ponderer->Misses()));
+		ponderer = nullptr;
+
+		resources->framebuffers.Release(sceneTarget);
+		gpuTimer = nullptr;
+		batch = nullptr;
+		text = nullptr;
 		render = nullptr;
+		resources = nullptr;
+
+		TRACE_EXPORT("sdmc:/SwitchHBTest_trace.json");
 
 		CleanupEGL();
 	}
 
+	input.Stop();
+	LOG_INFO("INPUT", "Input to present: avg %.2f ms, max %.2f ms over %llu presses", inputLatency.AverageMs(), inputLatency.MaxMs(),
+		static_cast<unsigned long long>(inputLatency.Samples()));
+
+	core::LogStop();
 #ifdef DEBUG
 	socketExit();
 #endif
@@ -0,0 +1,412 @@
+// Offline trainer of the NNUE evaluation network (ttt/nnue.hpp) from self-play records.
+//
+//   ttt_nnue_train [--size N] [--k K] [--epochs E] [--lr R] [--scale S] [--seed S]
+//                  --out file records.tttr...
+//
+// Every position before a move of a recorded game is a sample, labelled with the game result
+// from the point of view of the side to move (1 win, 0.5 tie, 0 loss). A float copy of the
+// network is trained by SGD on the squared error of sigmoid(output), each time a sample is
+// used it is seen through a random one of the 8 board symmetries. The float network has the
+// same clipped activations as the quantized one and its weights are clipped to the ranges
+// the quantized types can hold, so quantizing it at the end loses little.
+// Games of other dimensions than --size and --k (by default those of the first game) are
+// skipped.
+
+#include "../ttt/board.hpp"
+#include "../ttt/game_record.hpp"
+#include "../ttt/nnue.hpp"
+#include "../core/job_system.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+	constexpr unsigned int Hidden = ttt::NnueHidden;
+	constexpr unsigned int Layer = ttt::NnueLayer;
+	// Largest magnitudes the quantized weights can represent
+	constexpr float FeatureLimit = 1.0f;
+	constexpr float DenseLimit = 127.0f / ttt::NnueWeightScale;
+
+	struct Options {
+		unsigned int size = 0;
+		unsigned int winLength = 0;
+		unsigned int epochs = 10;
+		float learningRate = 0.01f;
+		int evalScale = 1000;
+		uint64_t seed = 1;
+		const char* outPath = nullptr;
+		std::vector<const char*> records;
+	};
+
+	// Positions of every sample, one byte per cell (a TileState), with their labels
+	struct Samples {
+		unsigned int cells = 0;
+		std::vector<uint8_t> tiles;
+		std::vector<uint8_t> sides;
+		std::vector<float> labels;
+
+		inline size_t Count() const { return labels.size(); }
+	};
+
+	struct FloatNetwork {
+		std::vector<float> featureWeights;	// [2 * cells][Hidden]
+		float featureBias[Hidden];
+		float hiddenWeights[Layer][2 * Hidden];
+		float hiddenBias[Layer];
+		float outputWeights[Layer];
+		float outputBias;
+	};
+
+	// Forward pass state of one sample, kept for the backward pass
+	struct Pass {
+		std::vector<unsigned int> features[2];
+		float accumulator[2][Hidden];
+		float input[2 * Hidden];
+		float hiddenSum[Layer];
+		float hidden[Layer];
+		float output;
+	};
+
+	inline float Clamp(float value, float limit) {
+		return std::min(std::max(value, -limit), limit);
+	}
+
+	inline float Activation(float value) {
+		return std::min(std::max(value, 0.0f), 1.0f);
+	}
+
+	inline float Sigmoid(float value) {
+		return 1.0f / (1.0f + std::exp(-value));
+	}
+
+	// Cell index of x, y seen through one of the 8 symmetries of a size x size board
+	unsigned int Transform(unsigned int symmetry, unsigned int x, unsigned int y, unsigned int size) {
+		unsigned int last = size - 1;
+		if (symmetry & 1) {
+			x = last - x;
+		}
+		if (symmetry & 2) {
+			y = last - y;
+		}
+		if (symmetry & 4) {
+			std::swap(x, y);
+		}
+		return y * size + x;
+	}
+
+	bool LoadSamples(const Options& options, core::JobSystem& jobs, unsigned int& size, unsigned int& winLength, Samples& samples) {
+		uint64_t skipped = 0;
+		for (const char* path : options.records) {
+			ttt::GameRecordReader reader;
+			if (!reader.Open(path)) {
+				return false;
+			}
+
+			ttt::GameRecordStats stats = reader.ComputeStats(jobs);
+			printf("%s: %llu games, %llu/%llu/%llu circle/cross/tie, %llu moves\n", path, static_cast<unsigned long long>(stats.games),
+				static_cast<unsigned long long>(stats.circleWins), static_cast<unsigned long long>(stats.crossWins),
+				static_cast<unsigned long long>(stats.ties), static_cast<unsigned long long>(stats.moves));
+
+			reader.ForEachGame([&](const ttt::GameView& game) {
+				if (size == 0) {
+					size = game.Size();
+					samples.cells = size * size;
+				}
+				if (winLength == 0 && game.Size() == size) {
+					winLength = game.WinLength();
+				}
+				if (game.Size() != size || game.WinLength() != winLength) {
+					skipped++;
+					return;
+				}
+
+				ttt::TileState winner = ttt::TileState::Empty;
+				if (game.Result() == ttt::BoardState::CircleWin) {
+					winner = ttt::TileState::Circle;
+				} else if (game.Result() == ttt::BoardState::CrossWin) {
+					winner = ttt::TileState::Cross;
+				}
+
+				std::vector<uint8_t> tiles(samples.cells, static_cast<uint8_t>(ttt::TileState::Empty));
+				ttt::TileState side = game.CrossFirst() ? ttt::TileState::Cross : ttt::TileState::Circle;
+				for (unsigned int i = 0; i < game.MoveCount(); i++) {
+					samples.tiles.insert(samples.tiles.end(), tiles.begin(), tiles.end());
+					samples.sides.push_back(static_cast<uint8_t>(side));
+					samples.labels.push_back(winner == ttt::TileState::Empty ? 0.5f : winner == side ? 1.0f : 0.0f);
+
+					tiles[game.CellIndex(i)] = static_cast<uint8_t>(side);
+					side = ttt::Opponent(side);
+				}
+			});
+		}
+
+		if (skipped > 0) {
+			printf("Skipped %llu games of other dimensions\n", static_cast<unsigned long long>(skipped));
+		}
+		return samples.Count() > 0;
+	}
+
+	void Initialize(FloatNetwork& network, unsigned int cells, std::mt19937_64& rng) {
+		std::uniform_real_distribution<float> feature(-0.1f, 0.1f);
+		std::uniform_real_distribution<float> dense(-0.3f, 0.3f);
+
+		network.featureWeights.resize(2 * cells * Hidden);
+		for (float& w : network.featureWeights) {
+			w = feature(rng);
+		}
+		// Start the clipped activations away from 0, where they would have no gradient
+		for (float& b : network.featureBias) {
+			b = 0.25f;
+		}
+		for (unsigned int i = 0; i < Layer; i++) {
+			for (float& w : network.hiddenWeights[i]) {
+				w = dense(rng);
+			}
+			network.hiddenBias[i] = 0.25f;
+			network.outputWeights[i] = dense(rng);
+		}
+		network.outputBias = 0.0f;
+	}
+
+	// Same feature layout as ttt::NnueNetwork::Feature()
+	void CollectFeatures(const Samples& samples, size_t sample, unsigned int size, unsigned int symmetry, Pass& pass) {
+		const uint8_t* tiles = &samples.tiles[sample * samples.cells];
+		for (unsigned int p = 0; p < 2; p++) {
+			ttt::TileState perspective = p == 0 ? ttt::TileState::Circle : ttt::TileState::Cross;
+			pass.features[p].clear();
+			for (unsigned int y = 0; y < size; y++) {
+				for (unsigned int x = 0; x < size; x++) {
+					ttt::TileState tile = static_cast<ttt::TileState>(tiles[y * size + x]);
+					if (tile == ttt::TileState::Circle || tile == ttt::TileState::Cross) {
+						pass.features[p].push_back((tile == perspective ? 0 : samples.cells) + Transform(symmetry, x, y, size));
+					}
+				}
+			}
+		}
+	}
+
+	void Forward(const FloatNetwork& network, unsigned int own, Pass& pass) {
+		for (unsigned int p = 0; p < 2; p++) {
+			float* accumulator = pass.accumulator[p];
+			memcpy(accumulator, network.featureBias, sizeof(network.featureBias));
+			for (unsigned int feature : pass.features[p]) {
+				const float* row = &network.featureWeights[feature * Hidden];
+				for (unsigned int j = 0; j < Hidden; j++) {
+					accumulator[j] += row[j];
+				}
+			}
+		}
+
+		for (unsigned int j = 0; j < Hidden; j++) {
+			pass.input[j] = Activation(pass.accumulator[own][j]);
+			pass.input[Hidden + j] = Activation(pass.accumulator[1 - own][j]);
+		}
+
+		pass.output = network.outputBias;
+		for (unsigned int i = 0; i < Layer; i++) {
+			float sum = network.hiddenBias[i];
+			for (unsigned int k = 0; k < 2 * Hidden; k++) {
+				sum += network.hiddenWeights[i][k] * pass.input[k];
+			}
+			pass.hiddenSum[i] = sum;
+			pass.hidden[i] = Activation(sum);
+			pass.output += network.outputWeights[i] * pass.hidden[i];
+		}
+	}
+
+	// One SGD step on the squared error of sigmoid(output), returns the error before the step
+	float Train(FloatNetwork& network, unsigned int own, float label, float learningRate, Pass& pass) {
+		Forward(network, own, pass);
+
+		float prediction = Sigmoid(pass.output);
+		float error = prediction - label;
+		float gradient = 2.0f * error * prediction * (1.0f - prediction);
+
+		float hiddenGradient[Layer];
+		for (unsigned int i = 0; i < Layer; i++) {
+			float sum = pass.hiddenSum[i];
+			hiddenGradient[i] = sum > 0.0f && sum < 1.0f ? gradient * network.outputWeights[i] : 0.0f;
+			network.outputWeights[i] = Clamp(network.outputWeights[i] - learningRate * gradient * pass.hidden[i], DenseLimit);
+		}
+		network.outputBias -= learningRate * gradient;
+
+		float inputGradient[2 * Hidden] = {};
+		for (unsigned int i = 0; i < Layer; i++) {
+			if (hiddenGradient[i] == 0.0f) {
+				continue;
+			}
+			for (unsigned int k = 0; k < 2 * Hidden; k++) {
+				inputGradient[k] += hiddenGradient[i] * network.hiddenWeights[i][k];
+				network.hiddenWeights[i][k] = Clamp(network.hiddenWeights[i][k] - learningRate * hiddenGradient[i] * pass.input[k], DenseLimit);
+			}
+			network.hiddenBias[i] -= learningRate * hiddenGradient[i];
+		}
+
+		for (unsigned int p = 0; p < 2; p++) {
+			const float* gradients = p == own ? inputGradient : inputGradient + Hidden;
+			float accumulatorGradient[Hidden];
+			for (unsigned int j = 0; j < Hidden; j++) {
+				float value = pass.accumulator[p][j];
+				accumulatorGradient[j] = value > 0.0f && value < 1.0f ? learningRate * gradients[j] : 0.0f;
+				network.featureBias[j] -= accumulatorGradient[j];
+			}
+			for (unsigned int feature : pass.features[p]) {
+				float* row = &network.featureWeights[feature * Hidden];
+				for (unsigned int j = 0; j < Hidden; j++) {
+					row[j] = Clamp(row[j] - accumulatorGradient[j], FeatureLimit);
+				}
+			}
+		}
+
+		return error * error;
+	}
+
+	template<typename T>
+	T Quantize(float value, float scale) {
+		float limit = static_cast<float>(std::numeric_limits<T>::max());
+		return static_cast<T>(std::lround(std::min(std::max(value * scale, -limit), limit)));
+	}
+
+	bool WriteNetwork(const char* path, const FloatNetwork& network, unsigned int size, unsigned int winLength, int evalScale) {
+		constexpr float activation = static_cast<float>(ttt::NnueActivationOne);
+		constexpr float weight = static_cast<float>(ttt::NnueWeightScale);
+
+		ttt::NnueFileHeader header {};
+		header.magic = ttt::NnueMagic;
+		header.version = ttt::NnueVersion;
+		header.size = static_cast<uint8_t>(size);
+		header.winLength = static_cast<uint8_t>(winLength);
+		header.hidden = Hidden;
+		header.layer = Layer;
+		header.evalScale = evalScale;
+
+		std::vector<uint8_t> data(reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header + 1));
+		auto append = [&data](const auto& value) {
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			data.insert(data.end(), bytes, bytes + sizeof(value));
+		};
+
+		for (float b : network.featureBias) {
+			append(Quantize<int16_t>(b, activation));
+		}
+		for (float w : network.featureWeights) {
+			append(Quantize<int16_t>(w, activation));
+		}
+		for (float b : network.hiddenBias) {
+			append(Quantize<int32_t>(b, activation * weight));
+		}
+		for (unsigned int i = 0; i < Layer; i++) {
+			for (float w : network.hiddenWeights[i]) {
+				append(Quantize<int8_t>(w, weight));
+			}
+		}
+		append(Quantize<int32_t>(network.outputBias, activation * weight));
+		for (float w : network.outputWeights) {
+			append(Quantize<int8_t>(w, weight));
+		}
+
+		FILE* file = fopen(path, "wb");
+		if (file == nullptr || fwrite(data.data(), 1, data.size(), file) != data.size()) {
+			fprintf(stderr, "Failed to write %s\n", path);
+			if (file != nullptr) {
+				fclose(file);
+			}
+			return false;
+		}
+		fclose(file);
+
+		printf("Wrote %s (%zu bytes)\n", path, data.size());
+		return true;
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options) {
+		for (int i = 1; i < argc; i++) {
+			const char* arg = argv[i];
+			if (arg[0] != '-') {
+				options.records.push_back(arg);
+				continue;
+			}
+
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (value == nullptr) {
+				fprintf(stderr, "Missing value for %s\n", arg);
+				return false;
+			}
+
+			if (strcmp(arg, "--size") == 0) {
+				options.size = atoi(value);
+			} else if (strcmp(arg, "--k") == 0) {
+				options.winLength = atoi(value);
+			} else if (strcmp(arg, "--epochs") == 0) {
+				options.epochs = atoi(value);
+			} else if (strcmp(arg, "--lr") == 0) {
+				options.learningRate = static_cast<float>(atof(value));
+			} else if (strcmp(arg, "--scale") == 0) {
+				options.evalScale = atoi(value);
+			} else if (strcmp(arg, "--seed") == 0) {
+				options.seed = strtoull(value, nullptr, 10);
+			} else if (strcmp(arg, "--out") == 0) {
+				options.outPath = value;
+			} else {
+				fprintf(stderr, "Unknown option %s\n", arg);
+				return false;
+			}
+			i++;
+		}
+
+		if (options.outPath == nullptr || options.records.empty() || options.size > ttt::Board::MaxSize) {
+			fprintf(stderr, "Missing output file or records, or invalid board size\n");
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		fprintf(stderr, "Usage: %s [--size N] [--k K] [--epochs E] [--lr R] [--scale S] [--seed S] --out file records.tttr...\n", argv[0]);
+		return 1;
+	}
+
+	unsigned int size = options.size;
+	unsigned int winLength = options.winLength;
+	Samples samples;
+	samples.cells = size * size;
+	// Only the record scan is parallel, training is a sequential SGD
+	core::JobSystem jobs;
+	if (!LoadSamples(options, jobs, size, winLength, samples)) {
+		fprintf(stderr, "No games to train on\n");
+		return 1;
+	}
+	printf("%zu positions of %ux%u, k = %u\n", samples.Count(), size, size, winLength);
+
+	std::mt19937_64 rng(options.seed);
+	FloatNetwork network;
+	Initialize(network, samples.cells, rng);
+
+	std::vector<size_t> order(samples.Count());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+
+	Pass pass;
+	for (unsigned int epoch = 0; epoch < options.epochs; epoch++) {
+		std::shuffle(order.begin(), order.end(), rng);
+
+		double loss = 0.0;
+		for (size_t sample : order) {
+			CollectFeatures(samples, sample, size, static_cast<unsigned int>(rng() & 7), pass);
+			unsigned int own = samples.sides[sample] == static_cast<uint8_t>(ttt::TileState::Circle) ? 0 : 1;
+			loss += Train(network, own, samples.labels[sample], options.learningRate, pass);
+		}
+		printf("Epoch %u: loss %.5f\n", epoch + 1, loss / order.size());
+	}
+
+	return WriteNetwork(options.outPath, network, size, winLength, options.evalScale) ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,464 @@
+// Headless self-play tournament between solver strategies.
+//
+//   ttt_tournament [--games N] [--threads T] [--seed S] [--size N] [--k K]
+//                  [--strategies a,b,...] [--record prefix] [--network file]
+//
+// Every pair of strategies plays N games per seating (each strategy gets to be circle and
+// cross, circle always moves first). Games are split in fixed chunks whose RNG seed only
+// depends on the tournament seed and the chunk index, so games between strategies without a
+// time budget (heuristic, random) do not depend on the number of threads. The other
+// strategies stop searching at a wall-clock deadline, how deep they get (and so which move
+// they play) depends on the load of the machine. Chunks are jobs of the work-stealing job
+// system (core/job_system.hpp), results and record files are per worker and merged at the
+// end.
+
+#include "../ttt/board.hpp"
+#include "../ttt/solver.hpp"
+#include "../ttt/search.hpp"
+#include "../ttt/pn_search.hpp"
+#include "../ttt/nnue.hpp"
+#include "../ttt/game_record.hpp"
+#include "../core/job_system.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	enum class StrategyKind {
+		Heuristic,
+		Random,
+		Search,
+		// Plays the first move of a proven win when proof-number search finds one within its
+		// node budget, the difficulty's search otherwise
+		Prover,
+		// The difficulty's search, evaluating its horizon with the --network weights
+		Network
+	};
+
+	struct Strategy {
+		const char* name;
+		StrategyKind kind;
+		ttt::Difficulty difficulty;
+		// Only plays 3x3 boards (ttt::NextMove only looks at the top-left 3x3 cells)
+		bool classicOnly;
+	};
+
+	const Strategy allStrategies[] = {
+		{ "heuristic", StrategyKind::Heuristic, ttt::Difficulty::Easy, true },
+		{ "random", StrategyKind::Random, ttt::Difficulty::Easy, false },
+		{ "easy", StrategyKind::Search, ttt::Difficulty::Easy, false },
+		{ "medium", StrategyKind::Search, ttt::Difficulty::Medium, false },
+		{ "hard", StrategyKind::Search, ttt::Difficulty::Hard, false },
+		{ "perfect", StrategyKind::Search, ttt::Difficulty::Perfect, false },
+		{ "prover", StrategyKind::Prover, ttt::Difficulty::Hard, false },
+		{ "nnue", StrategyKind::Network, ttt::Difficulty::Hard, false }
+	};
+
+	constexpr uint64_t ProverNodeBudget = 5000;
+
+	constexpr unsigned int ChunkSize = 256;
+
+	// Log-linear latency histogram: 8 sub-buckets per power of two nanoseconds
+	class LatencyHistogram {
+	protected:
+		static constexpr unsigned int SubBuckets = 8;
+		static constexpr unsigned int Buckets = 64 * SubBuckets;
+
+		uint64_t counts[Buckets];
+		uint64_t total;
+		uint64_t maxNs;
+
+		static unsigned int BucketOf(uint64_t ns) {
+			if (ns < SubBuckets) {
+				return static_cast<unsigned int>(ns);
+			}
+			unsigned int log = 63 - __builtin_clzll(ns);
+			unsigned int sub = static_cast<unsigned int>((ns >> (log - 3)) & (SubBuckets - 1));
+			return (log - 2) * SubBuckets + sub;
+		}
+
+		static uint64_t UpperBoundOf(unsigned int bucket) {
+			if (bucket < SubBuckets) {
+				return bucket;
+			}
+			unsigned int log = bucket / SubBuckets + 2;
+			uint64_t sub = bucket % SubBuckets;
+			return ((SubBuckets + sub + 1) << (log - 3)) - 1;
+		}
+	public:
+		LatencyHistogram() : counts(), total(0), maxNs(0) {}
+
+		void Add(uint64_t ns) {
+			counts[BucketOf(ns)]++;
+			total++;
+			maxNs = std::max(maxNs, ns);
+		}
+
+		void Merge(const LatencyHistogram& other) {
+			for (unsigned int i = 0; i < Buckets; i++) {
+				counts[i] += other.counts[i];
+			}
+			total += other.total;
+			maxNs = std::max(maxNs, other.maxNs);
+		}
+
+		uint64_t Percentile(double p) const {
+			if (total == 0) {
+				return 0;
+			}
+
+			uint64_t target = static_cast<uint64_t>(p * (total - 1)) + 1;
+			uint64_t seen = 0;
+			for (unsigned int i = 0; i < Buckets; i++) {
+				seen += counts[i];
+				if (seen >= target) {
+					return std::min(UpperBoundOf(i), maxNs);
+				}
+			}
+			return maxNs;
+		}
+
+		inline uint64_t Count() const { return total; }
+		inline uint64_t Max() const { return maxNs; }
+	};
+
+	struct Options {
+		uint64_t games = 10000;
+		unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+		uint64_t seed = 1;
+		unsigned int size = 3;
+		unsigned int winLength = 3;
+		std::vector<unsigned int> strategies;
+		const char* recordPrefix = nullptr;
+		const char* networkPath = nullptr;
+	};
+
+	// Results of one worker, indexed by [circle strategy][cross strategy]
+	struct WorkerResults {
+		std::vector<uint64_t> circleWins;
+		std::vector<uint64_t> crossWins;
+		std::vector<uint64_t> ties;
+		std::vector<LatencyHistogram> latency;
+		uint64_t games = 0;
+		uint64_t moves = 0;
+		// Games abandoned after an illegal move, not counted in the results above
+		uint64_t abandoned = 0;
+
+		WorkerResults(size_t strategyCount) :
+			circleWins(strategyCount * strategyCount), crossWins(strategyCount * strategyCount), ties(strategyCount * strategyCount), latency(strategyCount) {}
+	};
+
+	ttt::Coord PlayMove(const Strategy& strategy, const ttt::Board& board, ttt::TileState side, const ttt::NnueNetwork& network, std::mt19937_64& rng) {
+		switch (strategy.kind) {
+			case StrategyKind::Heuristic: {
+				ttt::Board copy = board;
+				ttt::NextMove(copy, side == ttt::TileState::Circle);
+				for (unsigned int y = 0; y < board.Size(); y++) {
+					for (unsigned int x = 0; x < board.Size(); x++) {
+						if (copy.Get(x, y) != board.Get(x, y)) {
+							return ttt::Coord { x, y };
+						}
+					}
+				}
+				break;
+			}
+			case StrategyKind::Random: {
+				unsigned int empty = board.EmptyCount();
+				unsigned int pick = static_cast<unsigned int>(rng() % empty);
+				for (unsigned int y = 0; y < board.Size(); y++) {
+					for (unsigned int x = 0; x < board.Size(); x++) {
+						if (board.Get(x, y) == ttt::TileState::Empty && pick-- == 0) {
+							return ttt::Coord { x, y };
+						}
+					}
+				}
+				break;
+			}
+			case StrategyKind::Prover: {
+				// One table per worker thread, kept over its games
+				static thread_local ttt::ProofSearch prover(1 << 16);
+				ttt::ProofResult proof = prover.Prove(board, side, ttt::ProofLimits { ProverNodeBudget, std::chrono::microseconds(0) });
+				if (proof.outcome == ttt::ProofOutcome::Win && proof.lineLength > 0) {
+					return proof.line[0];
+				}
+				[[fallthrough]];
+			}
+			case StrategyKind::Network:
+			case StrategyKind::Search: {
+				ttt::SearchLimits limits = ttt::LimitsFor(strategy.difficulty);
+				if (strategy.kind == StrategyKind::Network) {
+					limits.network = &network;
+				}
+				ttt::SearchResult result = ttt::Search(board, side, limits, static_cast<uint32_t>(rng()));
+				if (result.valid) {
+					return result.move;
+				}
+				break;
+			}
+		}
+
+		// A strategy that found no move forfeits its turn to the first empty cell
+		for (unsigned int y = 0; y < board.Size(); y++) {
+			for (unsigned int x = 0; x < board.Size(); x++) {
+				if (board.Get(x, y) == ttt::TileState::Empty) {
+					return ttt::Coord { x, y };
+				}
+			}
+		}
+		return ttt::Coord { board.Size(), board.Size() };
+	}
+
+	// Plays the games of one chunk. Its RNG seed only depends on the tournament seed and the
+	// chunk index, whichever worker plays it.
+	void PlayChunk(const Options& options, const ttt::NnueNetwork& network, uint64_t chunk, uint64_t totalGames, WorkerResults& results, ttt::GameRecordWriter& writer) {
+		size_t count = options.strategies.size();
+		uint64_t gamesPerPairing = options.games;
+		ttt::GameRecord record;
+
+		uint64_t first = chunk * ChunkSize;
+		uint64_t last = std::min(first + ChunkSize, totalGames);
+
+		std::mt19937_64 rng(options.seed * 0x9E3779B97F4A7C15ull + chunk);
+		for (uint64_t game = first; game < last; game++) {
+			uint64_t pairing = game / gamesPerPairing;
+			unsigned int circle = static_cast<unsigned int>(pairing / count);
+			unsigned int cross = static_cast<unsigned int>(pairing % count);
+			const Strategy& circleStrategy = allStrategies[options.strategies[circle]];
+			const Strategy& crossStrategy = allStrategies[options.strategies[cross]];
+
+			ttt::Board board(options.size, options.winLength);
+			record.Reset(board, false, static_cast<uint8_t>(options.strategies[circle]), static_cast<uint8_t>(options.strategies[cross]));
+
+			ttt::TileState side = ttt::TileState::Circle;
+			bool legal = true;
+			while (legal && board.GetState() == ttt::BoardState::Regular) {
+				bool circleToMove = side == ttt::TileState::Circle;
+
+				auto start = Clock::now();
+				ttt::Coord move = PlayMove(circleToMove ? circleStrategy : crossStrategy, board, side, network, rng);
+				uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+				results.latency[circleToMove ? circle : cross].Add(elapsed);
+
+				if (!board.Set(move, side)) {
+					fprintf(stderr, "Strategy %s played an illegal move, game abandoned\n", circleToMove ? circleStrategy.name : crossStrategy.name);
+					legal = false;
+					break;
+				}
+				record.Add(move);
+				results.moves++;
+				side = ttt::Opponent(side);
+			}
+			if (!legal) {
+				results.abandoned++;
+				continue;
+			}
+
+			size_t cell = circle * count + cross;
+			switch (board.GetState()) {
+				case ttt::BoardState::CircleWin:
+					results.circleWins[cell]++;
+					break;
+				case ttt::BoardState::CrossWin:
+					results.crossWins[cell]++;
+					break;
+				default:
+					results.ties[cell]++;
+					break;
+			}
+			results.games++;
+
+			if (writer.IsOpen()) {
+				record.result = board.GetState();
+				writer.Append(record);
+			}
+		}
+	}
+
+	bool ParseStrategies(const char* list, std::vector<unsigned int>& out) {
+		out.clear();
+		std::string names(list);
+		size_t start = 0;
+		while (start <= names.size()) {
+			size_t end = names.find(',', start);
+			if (end == std::string::npos) {
+				end = names.size();
+			}
+
+			std::string name = names.substr(start, end - start);
+			bool found = false;
+			for (unsigned int i = 0; i < sizeof(allStrategies) / sizeof(allStrategies[0]); i++) {
+				if (name == allStrategies[i].name) {
+					out.push_back(i);
+					found = true;
+				}
+			}
+			if (!found) {
+				fprintf(stderr, "Unknown strategy '%s'\n", name.c_str());
+				return false;
+			}
+			start = end + 1;
+		}
+		return !out.empty();
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options) {
+		for (int i = 1; i < argc; i++) {
+			const char* arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+			if (value == nullptr) {
+				fprintf(stderr, "Missing value for %s\n", arg);
+				return false;
+			}
+
+			if (strcmp(arg, "--games") == 0) {
+				options.games = strtoull(value, nullptr, 10);
+			} else if (strcmp(arg, "--threads") == 0) {
+				options.threads = std::max(1, atoi(value));
+			} else if (strcmp(arg, "--seed") == 0) {
+				options.seed = strtoull(value, nullptr, 10);
+			} else if (strcmp(arg, "--size") == 0) {
+				options.size = atoi(value);
+			} else if (strcmp(arg, "--k") == 0) {
+				options.winLength = atoi(value);
+			} else if (strcmp(arg, "--strategies") == 0) {
+				if (!ParseStrategies(value, options.strategies)) {
+					return false;
+				}
+			} else if (strcmp(arg, "--record") == 0) {
+				options.recordPrefix = value;
+			} else if (strcmp(arg, "--network") == 0) {
+				options.networkPath = value;
+			} else {
+				fprintf(stderr, "Unknown option %s\n", arg);
+				return false;
+			}
+			i++;
+		}
+
+		if (options.size < 1 || options.size > ttt::Board::MaxSize || options.games == 0) {
+			fprintf(stderr, "Invalid board size or game count\n");
+			return false;
+		}
+
+		// The default field leaves out strategies that cannot play the board size
+		if (options.strategies.empty()) {
+			for (unsigned int i = 0; i < sizeof(allStrategies) / sizeof(allStrategies[0]); i++) {
+				if (!allStrategies[i].classicOnly || options.size == 3) {
+					options.strategies.push_back(i);
+				}
+			}
+		}
+
+		for (unsigned int strategy : options.strategies) {
+			if (allStrategies[strategy].classicOnly && options.size != 3) {
+				fprintf(stderr, "Strategy %s only plays 3x3 boards\n", allStrategies[strategy].name);
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	if (!ParseOptions(argc, argv, options)) {
+		fprintf(stderr, "Usage: %s [--games N] [--threads T] [--seed S] [--size N] [--k K] [--strategies a,b,...] [--record prefix] [--network file]\n", argv[0]);
+		return 1;
+	}
+
+	// Without matching weights the nnue strategy plays like its difficulty's search
+	ttt::NnueNetwork network;
+	if (options.networkPath != nullptr && !network.LoadFile(options.networkPath)) {
+		return 1;
+	}
+	ttt::Board board(options.size, options.winLength);
+	if (network.IsLoaded() && !network.Matches(board)) {
+		fprintf(stderr, "%s was not trained for %ux%u, k = %u\n", options.networkPath, options.size, options.size, options.winLength);
+		return 1;
+	}
+
+	size_t count = options.strategies.size();
+	uint64_t totalGames = options.games * count * count;
+	printf("%llu games (%llu per seating) on %ux%u, k = %u, %u threads, seed %llu\n",
+		static_cast<unsigned long long>(totalGames), static_cast<unsigned long long>(options.games),
+		options.size, options.size, options.winLength, options.threads, static_cast<unsigned long long>(options.seed));
+
+	// The main thread is one of the workers
+	core::JobSystem jobs(options.threads - 1);
+	unsigned int workers = jobs.WorkerCount();
+	std::vector<WorkerResults> results(workers, WorkerResults(count));
+	std::unique_ptr<ttt::GameRecordWriter[]> writers(new ttt::GameRecordWriter[workers]);
+	if (options.recordPrefix != nullptr) {
+		for (unsigned int w = 0; w < workers; w++) {
+			std::string path = std::string(options.recordPrefix) + "." + std::to_string(w) + ".tttr";
+			writers[w].Open(path.c_str());
+		}
+	}
+
+	auto start = Clock::now();
+	uint64_t chunks = (totalGames + ChunkSize - 1) / ChunkSize;
+	jobs.ParallelFor(static_cast<uint32_t>(chunks), 1, [&](uint32_t begin, uint32_t end) {
+		unsigned int worker = jobs.CurrentWorker();
+		for (uint32_t chunk = begin; chunk < end; chunk++) {
+			PlayChunk(options, network, chunk, totalGames, results[worker], writers[worker]);
+		}
+	});
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	WorkerResults total(count);
+	for (const auto& worker : results) {
+		for (size_t i = 0; i < count * count; i++) {
+			total.circleWins[i] += worker.circleWins[i];
+			total.crossWins[i] += worker.crossWins[i];
+			total.ties[i] += worker.ties[i];
+		}
+		for (size_t i = 0; i < count; i++) {
+			total.latency[i].Merge(worker.latency[i]);
+		}
+		total.games += worker.games;
+		total.moves += worker.moves;
+		total.abandoned += worker.abandoned;
+	}
+
+	printf("\n%.2f s, %.0f games/s, %.0f moves/s\n", seconds, total.games / seconds, total.moves / seconds);
+	if (total.abandoned > 0) {
+		printf("%llu games abandoned after an illegal move\n", static_cast<unsigned long long>(total.abandoned));
+	}
+
+	// Row strategy against column strategy, both seatings combined: wins/draws/losses
+	printf("\nW/D/L of row vs column (both seatings)\n%-10s", "");
+	for (size_t c = 0; c < count; c++) {
+		printf(" %22s", allStrategies[options.strategies[c]].name);
+	}
+	printf("\n");
+	for (size_t r = 0; r < count; r++) {
+		printf("%-10s", allStrategies[options.strategies[r]].name);
+		for (size_t c = 0; c < count; c++) {
+			uint64_t wins = total.circleWins[r * count + c] + total.crossWins[c * count + r];
+			uint64_t losses = total.crossWins[r * count + c] + total.circleWins[c * count + r];
+			uint64_t draws = total.ties[r * count + c] + total.ties[c * count + r];
+			char cell[64];
+			snprintf(cell, sizeof(cell), "%llu/%llu/%llu", static_cast<unsigned long long>(wins), static_cast<unsigned long long>(draws), static_cast<unsigned long long>(losses));
+			printf(" %22s", cell);
+		}
+		printf("\n");
+	}
+
+	printf("\nMove latency (us)\n%-10s %12s %10s %10s %10s %10s\n", "", "moves", "p50", "p90", "p99", "max");
+	for (size_t s = 0; s < count; s++) {
+		const LatencyHistogram& h = total.latency[s];
+		printf("%-10s %12llu %10.2f %10.2f %10.2f %10.2f\n", allStrategies[options.strategies[s]].name, static_cast<unsigned long long>(h.Count()),
+			h.Percentile(0.5) / 1000.0, h.Percentile(0.9) / 1000.0, h.Percentile(0.99) / 1000.0, h.Max() / 1000.0);
+	}
+
+	return 0;
+}
\ No newline at end of file
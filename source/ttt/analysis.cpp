@@ -0,0 +1,256 @@
+#include "analysis.hpp"
+#include "search.hpp"
+#include "../core/trace.hpp"
+
+namespace ttt {
+	namespace {
+		typedef std::chrono::steady_clock Clock;
+
+		// How often (in nodes) the deadline is checked
+		constexpr uint64_t TimeCheckInterval = 1024;
+
+		// Table depth of a fully solved subtree
+		constexpr uint16_t SolvedDepth = 0xFFFF;
+
+		constexpr unsigned int MaxMoves = Board::MaxSize * Board::MaxSize;
+
+		inline Coord UnpackMove(uint8_t move) {
+			return Coord { move % Board::MaxSize, move / Board::MaxSize };
+		}
+
+		// Every empty cell, from the center outwards, with hint (if legal) first
+		unsigned int GenerateMoves(const Board& board, uint8_t hint, uint8_t* moves) {
+			int size = static_cast<int>(board.Size());
+			int center = size - 1;
+			unsigned int count = 0;
+			unsigned int keys[MaxMoves];
+
+			for (int y = 0; y < size; y++) {
+				for (int x = 0; x < size; x++) {
+					if (board.Get(x, y) != TileState::Empty) {
+						continue;
+					}
+
+					uint8_t move = static_cast<uint8_t>(y * Board::MaxSize + x);
+					int dx = x * 2 - center;
+					int dy = y * 2 - center;
+					unsigned int key = move == hint ? 0 : 1 + static_cast<unsigned int>((dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy));
+
+					unsigned int j = count++;
+					while (j > 0 && keys[j - 1] > key) {
+						moves[j] = moves[j - 1];
+						keys[j] = keys[j - 1];
+						j--;
+					}
+					moves[j] = move;
+					keys[j] = key;
+				}
+			}
+
+			return count;
+		}
+
+		// Exact alpha-beta solver (no depth limit, no heuristic) on top of a shared table
+		class Solver {
+		public:
+			Board board;
+			TranspositionTable* table;
+			Clock::time_point deadline;
+			bool hasDeadline;
+			uint64_t nodes;
+			bool aborted;
+
+			Solver(const Board& board, TranspositionTable& table, std::chrono::microseconds budget) : board(board), table(&table), hasDeadline(budget.count() > 0), nodes(0), aborted(false) {
+				deadline = Clock::now() + budget;
+			}
+
+			inline bool TimeUp() {
+				if (!aborted && hasDeadline && (nodes % TimeCheckInterval) == 0 && Clock::now() >= deadline) {
+					aborted = true;
+				}
+				return aborted;
+			}
+
+			// Score of playing move for toMove, from toMove's point of view
+			int ScoreMove(uint8_t move, int alpha, int beta, unsigned int ply, TileState toMove) {
+				Coord c = UnpackMove(move);
+				board.Set(c, toMove);
+
+				int score;
+				switch (board.GetState()) {
+					case BoardState::CircleWin:
+					case BoardState::CrossWin:
+						score = WinScore - static_cast<int>(ply + 1);
+						break;
+					case BoardState::Tied:
+						score = 0;
+						break;
+					default:
+						score = -Solve(-beta, -alpha, ply + 1, Opponent(toMove));
+						break;
+				}
+
+				board.Unset(c);
+				return score;
+			}
+
+			int Solve(int alpha, int beta, unsigned int ply, TileState toMove) {
+				nodes++;
+				if (TimeUp()) {
+					return 0;
+				}
+
+				uint64_t key = board.Hash() ^ SideKey(toMove);
+				uint8_t hint = NoMove;
+				TableEntry entry;
+				if (table->Probe(key, entry)) {
+					int score = ScoreFromTable(entry.score, ply);
+					if (entry.depth == SolvedDepth) {
+						if (entry.bound == Bound::Exact) {
+							return score;
+						}
+						if (entry.bound == Bound::Lower && score > alpha) {
+							alpha = score;
+						} else if (entry.bound == Bound::Upper && score < beta) {
+							beta = score;
+						}
+						if (alpha >= beta) {
+							return score;
+						}
+					}
+					hint = entry.move;
+				}
+
+				uint8_t moves[MaxMoves];
+				unsigned int count = GenerateMoves(board, hint, moves);
+
+				int originalAlpha = alpha;
+				int best = -WinScore;
+				uint8_t bestMove = NoMove;
+				for (unsigned int i = 0; i < count; i++) {
+					int score = ScoreMove(moves[i], alpha, beta, ply, toMove);
+					if (aborted) {
+						return 0;
+					}
+
+					if (score > best) {
+						best = score;
+						bestMove = moves[i];
+					}
+					if (score > alpha) {
+						alpha = score;
+					}
+					if (alpha >= beta) {
+						break;
+					}
+				}
+
+				Bound bound = best <= originalAlpha ? Bound::Upper : best >= beta ? Bound::Lower : Bound::Exact;
+				table->Store(key, ScoreToTable(best, ply), bestMove, bound, SolvedDepth);
+				return best;
+			}
+		};
+	}
+
+	Analyzer::Analyzer(size_t tableEntries) : table(tableEntries), useCounter(0), hits(0), misses(0) {
+		Clear();
+	}
+
+	void Analyzer::Clear() {
+		for (unsigned int i = 0; i < CacheSize; i++) {
+			cache[i].key = 0;
+			cache[i].side = TileState::Invalid;
+			lastUsed[i] = 0;
+		}
+		table.Clear();
+	}
+
+	PositionAnalysis& Analyzer::Slot(uint64_t key, TileState side, bool& found) {
+		unsigned int oldest = 0;
+		for (unsigned int i = 0; i < CacheSize; i++) {
+			if (cache[i].key == key && cache[i].side == side) {
+				lastUsed[i] = ++useCounter;
+				found = true;
+				return cache[i];
+			}
+			if (lastUsed[i] < lastUsed[oldest]) {
+				oldest = i;
+			}
+		}
+
+		lastUsed[oldest] = ++useCounter;
+		found = false;
+		return cache[oldest];
+	}
+
+	const PositionAnalysis& Analyzer::Analyze(const Board& board, TileState side, std::chrono::microseconds budget) {
+		uint64_t key = board.Hash() ^ SideKey(side);
+		bool found;
+		PositionAnalysis& analysis = Slot(key, side, found);
+		if (found && analysis.complete) {
+			hits++;
+			return analysis;
+		}
+
+		TRACE_ZONE("ttt::Analyze");
+
+		if (!found) {
+			misses++;
+			analysis.key = key;
+			analysis.side = side;
+			analysis.nodes = 0;
+			for (unsigned int i = 0; i < MaxMoves; i++) {
+				analysis.moves[i] = MoveValue { MoveOutcome::None, 0, 0 };
+			}
+
+			if (board.GetState() != BoardState::Regular) {
+				analysis.complete = true;
+				return analysis;
+			}
+		}
+
+		Solver solver(board, table, budget);
+
+		uint8_t moves[MaxMoves];
+		unsigned int count = GenerateMoves(board, NoMove, moves);
+
+		// Every move is searched with a full window, the overlay needs exact values and not
+		// just the best move. Moves proven by an earlier, interrupted call are kept.
+		analysis.complete = true;
+		for (unsigned int i = 0; i < count; i++) {
+			MoveValue& value = analysis.moves[moves[i]];
+			if (value.outcome != MoveOutcome::None && value.outcome != MoveOutcome::Unknown) {
+				continue;
+			}
+
+			value = MoveValue { MoveOutcome::Unknown, 0, 0 };
+			if (solver.aborted) {
+				analysis.complete = false;
+				continue;
+			}
+
+			int score = solver.ScoreMove(moves[i], -WinScore, WinScore, 0, side);
+			if (solver.aborted) {
+				analysis.complete = false;
+				continue;
+			}
+
+			value.score = score;
+			if (score >= WinThreshold) {
+				value.outcome = MoveOutcome::Win;
+				value.distance = static_cast<unsigned int>(WinScore - score);
+			} else if (score <= -WinThreshold) {
+				value.outcome = MoveOutcome::Loss;
+				value.distance = static_cast<unsigned int>(WinScore + score);
+			} else {
+				// A drawn game only ends once the board is full
+				value.outcome = MoveOutcome::Draw;
+				value.distance = board.EmptyCount();
+			}
+		}
+
+		analysis.nodes += solver.nodes;
+		TRACE_COUNTER("ttt::Analyze nodes", analysis.nodes);
+		return analysis;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include "board.hpp"
+#include "transposition.hpp"
+#include <chrono>
+#include <cstdint>
+
+namespace ttt {
+	enum class MoveOutcome : uint8_t {
+		// Occupied cell or no legal move
+		None,
+		// Not proven yet within the time budget
+		Unknown,
+		Win,
+		Draw,
+		Loss
+	};
+
+	// Game-theoretic value of a move for the side playing it
+	struct MoveValue {
+		MoveOutcome outcome;
+		// Plies until the game ends with perfect play, the move itself included
+		unsigned int distance;
+		// Search score, see search.hpp
+		int score;
+	};
+
+	struct PositionAnalysis {
+		// Board::Hash() ^ SideKey(side)
+		uint64_t key;
+		TileState side;
+		// False while some legal move is still Unknown
+		bool complete;
+		uint64_t nodes;
+		MoveValue moves[Board::MaxSize * Board::MaxSize];
+
+		inline const MoveValue& At(unsigned int x, unsigned int y) const { return moves[y * Board::MaxSize + x]; }
+	};
+
+	// Values of every legal move of a position, for the analysis overlay.
+	// Results are cached per position, so asking again for the same board (the cursor moved,
+	// the overlay is redrawn) costs a lookup. A new position is solved with alpha-beta on top
+	// of a transposition table that is kept between positions: after a move, most of the new
+	// tree was already proven while analyzing the previous position, so only the part the
+	// move opened up is searched again.
+	class Analyzer {
+	public:
+		static constexpr unsigned int CacheSize = 16;
+	protected:
+		TranspositionTable table;
+		PositionAnalysis cache[CacheSize];
+		unsigned long long lastUsed[CacheSize];
+		unsigned long long useCounter;
+		uint64_t hits;
+		uint64_t misses;
+
+		PositionAnalysis& Slot(uint64_t key, TileState side, bool& found);
+	public:
+		explicit Analyzer(size_t tableEntries = 1 << 16);
+		Analyzer(const Analyzer&) = delete;
+		Analyzer& operator=(const Analyzer&) = delete;
+
+		// Values of every empty cell for side. budget bounds the work of one call, 0 disables
+		// the limit; an incomplete analysis is resumed by the next call for the same position.
+		const PositionAnalysis& Analyze(const Board& board, TileState side, std::chrono::microseconds budget);
+		// Drops every cached result, needed if the rules change
+		void Clear();
+
+		inline uint64_t Hits() const { return hits; }
+		inline uint64_t Misses() const { return misses; }
+	};
+}
\ No newline at end of file
@@ -1,21 +1,41 @@
 #include "board.hpp"
 
 namespace ttt {
-    Board::Board() {
+    Board::Board(unsigned int size, unsigned int winLength) {
+        if (size < 1) {
+            size = 1;
+        } else if (size > MaxSize) {
+            size = MaxSize;
+        }
+
+        if (winLength < 1) {
+            winLength = 1;
+        } else if (winLength > size) {
+            winLength = size;
+        }
+
+        this->size = size;
+        this->winLength = winLength;
         Reset();
     }
 
     void Board::Reset() {
-        for(int x = 0; x < 3; x++) {
-            for(int y = 0; y < 3; y++) {
+        for(unsigned int x = 0; x < MaxSize; x++) {
+            for(unsigned int y = 0; y < MaxSize; y++) {
                 tiles[y][x] = TileState::Empty;
             }
         }
+        for (unsigned int i = 0; i < MaxLines; i++) {
+            lines[i][0] = 0;
+            lines[i][1] = 0;
+        }
+        moveCount = 0;
         state = BoardState::Regular;
+        hash = MixKey(0x10000 | (size << 8) | winLength);
     }
 
     TileState Board::Get(unsigned int x, unsigned int y) const {
-        if (x >= 3 || x < 0 || y >= 3 || y < 0) {
+        if (x >= size || y >= size) {
             return TileState::Invalid;
         }
 
@@ -27,7 +47,7 @@ namespace ttt {
     }
 
     bool Board::Set(unsigned int x, unsigned int y, TileState value) {
-        if (x >= 3 || x < 0 || y >= 3 || y < 0) {
+        if (x >= size || y >= size) {
             return false;
         }
 
@@ -36,8 +56,11 @@ namespace ttt {
         }
 
         tiles[y][x] = value;
+        moveCount++;
+        hash ^= ZobristKey(y * MaxSize + x, value);
+        ToggleLines(x, y, value);
 
-        Update();
+        Update(x, y);
         return true;
     }
 
@@ -45,45 +68,103 @@ namespace ttt {
         return Set(c.x, c.y, value);
     }
 
-    BoardState Board::GetState() {
+    bool Board::Unset(unsigned int x, unsigned int y) {
+        if (x >= size || y >= size) {
+            return false;
+        }
+
+        if (tiles[y][x] == TileState::Empty) {
+            return false;
+        }
+
+        hash ^= ZobristKey(y * MaxSize + x, tiles[y][x]);
+        ToggleLines(x, y, tiles[y][x]);
+        tiles[y][x] = TileState::Empty;
+        moveCount--;
+        state = BoardState::Regular;
+        return true;
+    }
+
+    bool Board::Unset(Coord c) {
+        return Unset(c.x, c.y);
+    }
+
+    BoardState Board::GetState() const {
         return state;
     }
 
-    void Board::Update() {
-        for(int y = 0; y < 3; y++) {
-            if((tiles[y][0] == TileState::Circle || tiles[y][0] == TileState::Cross) && tiles[y][0] == tiles[y][1] && tiles[y][1] == tiles[y][2]) {
-                state = tiles[y][0] == TileState::Circle ? BoardState::CircleWin : BoardState::CrossWin;
-                return;
-            }
+    unsigned int Board::LineLength(unsigned int line) const {
+        if (line < 2 * size) {
+            return size;
         }
 
-        for(int x = 0; x < 3; x++) {
-            if((tiles[0][x] == TileState::Circle || tiles[0][x] == TileState::Cross) && tiles[0][x] == tiles[1][x] && tiles[1][x] == tiles[2][x]) {
-                state = tiles[0][x] == TileState::Circle ? BoardState::CircleWin : BoardState::CrossWin;
-                return;
-            }
+        unsigned int diagonal = line < 4 * size - 1 ? line - 2 * size : line - (4 * size - 1);
+        return diagonal < size ? diagonal + 1 : 2 * size - 1 - diagonal;
+    }
+
+    Coord Board::LineCell(unsigned int line, unsigned int index) const {
+        if (line < size) {
+            return Coord { index, line };
+        }
+        if (line < 2 * size) {
+            return Coord { line - size, index };
+        }
+        if (line < 4 * size - 1) {
+            // x - y = diagonal - (size - 1), starting on the top row or the left column
+            unsigned int diagonal = line - 2 * size;
+            return diagonal >= size - 1 ? Coord { diagonal - (size - 1) + index, index } : Coord { index, size - 1 - diagonal + index };
         }
 
-        if ((tiles[0][0] == TileState::Circle || tiles[0][0] == TileState::Cross) && tiles[1][1] == tiles[0][0] && tiles[2][2] == tiles[0][0]) {
-            state = tiles[0][0] == TileState::Circle ? BoardState::CircleWin : BoardState::CrossWin;
+        // x + y = sum, starting on the left column or the bottom row
+        unsigned int sum = line - (4 * size - 1);
+        unsigned int startX = sum >= size ? sum - (size - 1) : 0;
+        return Coord { startX + index, sum - startX - index };
+    }
+
+    void Board::CellLines(unsigned int x, unsigned int y, unsigned int* lineIndices, unsigned int* bits) const {
+        lineIndices[0] = y;
+        bits[0] = x;
+        lineIndices[1] = size + x;
+        bits[1] = y;
+        lineIndices[2] = 2 * size + x + size - 1 - y;
+        bits[2] = x < y ? x : y;
+        lineIndices[3] = 4 * size - 1 + x + y;
+        bits[3] = x + y >= size ? size - 1 - y : x;
+    }
+
+    void Board::ToggleLines(unsigned int x, unsigned int y, TileState value) {
+        if (value != TileState::Circle && value != TileState::Cross) {
             return;
         }
 
-        
-        if ((tiles[0][2] == TileState::Circle || tiles[0][2] == TileState::Cross) && tiles[1][1] == tiles[0][2] && tiles[2][0] == tiles[0][2]) {
-            state = tiles[0][2] == TileState::Circle ? BoardState::CircleWin : BoardState::CrossWin;
+        unsigned int lineIndices[4];
+        unsigned int bits[4];
+        CellLines(x, y, lineIndices, bits);
+        unsigned int side = value == TileState::Cross ? 1 : 0;
+        for (unsigned int i = 0; i < 4; i++) {
+            lines[lineIndices[i]][side] ^= static_cast<uint16_t>(1u << bits[i]);
+        }
+    }
+
+    // Only lines through the last placed tile can have changed, so only those are checked
+    void Board::Update(unsigned int x, unsigned int y) {
+        if (state != BoardState::Regular) {
             return;
         }
 
-        for(int x = 0; x < 3; x++) {
-            for(int y = 0; y < 3; y++) {
-                if (tiles[y][x] == TileState::Empty) {
-                    state = BoardState::Regular;
+        TileState placed = tiles[y][x];
+        if (placed == TileState::Circle || placed == TileState::Cross) {
+            unsigned int lineIndices[4];
+            unsigned int bits[4];
+            CellLines(x, y, lineIndices, bits);
+            for (unsigned int i = 0; i < 4; i++) {
+                if (ContainsRun(LineMask(lineIndices[i], placed), winLength)) {
+                    state = placed == TileState::Circle ? BoardState::CircleWin : BoardState::CrossWin;
                     return;
                 }
             }
         }
 
-        state = BoardState::Tied;
+        state = moveCount >= size * size ? BoardState::Tied : BoardState::Regular;
     }
 }
\ No newline at end of file
@@ -1,17 +1,18 @@
 #pragma once
 #include <iterator>
+#include <cstdint>
 
 namespace ttt {
 	struct Coord {
 		unsigned int x, y;
 
-		void Normalize() {
-			x %= 3;
-			y %= 3;
+		void Normalize(unsigned int size = 3) {
+			x %= size;
+			y %= size;
 		}
 	};
 
-	enum class TileState {
+	enum class TileState : uint8_t {
 		Invalid,
 		Empty,
 		Circle,
@@ -25,22 +26,84 @@ namespace ttt {
 		CrossWin
 	};
 
+	inline TileState Opponent(TileState side) {
+		return side == TileState::Circle ? TileState::Cross : TileState::Circle;
+	}
+
+	// SplitMix64 finalizer, spreads a small integer over all 64 bits
+	inline uint64_t MixKey(uint64_t value) {
+		value += 0x9E3779B97F4A7C15ull;
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+
+	// Zobrist key of a tile of side on the cell index (y * MaxSize + x)
+	inline uint64_t ZobristKey(unsigned int index, TileState side) {
+		return MixKey(index * 2 + (side == TileState::Cross ? 1 : 0));
+	}
+
+	// True when mask holds at least length consecutive set bits
+	inline bool ContainsRun(uint32_t mask, unsigned int length) {
+		for (unsigned int i = 1; i < length && mask != 0; i++) {
+			mask &= mask >> 1;
+		}
+		return mask != 0;
+	}
+
+	// Square k-in-a-row board. The classic game is the default 3x3 board with k = 3, larger
+	// boards (up to MaxSize) are used by the solver and the self-play tools.
+	//
+	// Besides the tiles, the board keeps one bitmask per side for each of its lines (rows,
+	// columns, diagonals and anti-diagonals), updated by every Set/Unset. Win detection and
+	// the pattern tables (patterns.hpp) work on those masks instead of reading cells.
 	class Board {
+	public:
+		static constexpr unsigned int MaxSize = 15;
+		static constexpr unsigned int MaxLines = 6 * MaxSize - 2;
 	protected:
-		TileState tiles[3][3];
+		TileState tiles[MaxSize][MaxSize];
+		unsigned int size;
+		unsigned int winLength;
+		unsigned int moveCount;
 		BoardState state;
+		uint64_t hash;
+		// [line][0 Circle, 1 Cross]
+		uint16_t lines[MaxLines][2];
 
-		void Update();
+		// The four lines through x, y and the bit of the cell in each
+		void CellLines(unsigned int x, unsigned int y, unsigned int* lineIndices, unsigned int* bits) const;
+		void ToggleLines(unsigned int x, unsigned int y, TileState value);
+		void Update(unsigned int x, unsigned int y);
 	public:
 
-		Board();
+		Board(unsigned int size = 3, unsigned int winLength = 3);
 		TileState Get(unsigned int x, unsigned int y) const;
 		TileState Get(Coord c) const;
 		bool Set(unsigned int x, unsigned int y, TileState value);
 		bool Set(Coord c, TileState value);
+		// Takes back a move. The board can only have been playable before it, so the state
+		// goes back to Regular.
+		bool Unset(unsigned int x, unsigned int y);
+		bool Unset(Coord c);
 		void Reset();
 		
-		BoardState GetState();
+		BoardState GetState() const;
+		inline unsigned int Size() const { return size; }
+		inline unsigned int WinLength() const { return winLength; }
+		inline unsigned int MoveCount() const { return moveCount; }
+		inline unsigned int EmptyCount() const { return size * size - moveCount; }
+		// Zobrist hash of the tiles and the board dimensions, updated incrementally by every
+		// Set/Unset. It does not include the side to move.
+		inline uint64_t Hash() const { return hash; }
+
+		// Lines are numbered rows first (by y), then columns (by x), diagonals going down-right
+		// (by x - y + size - 1) and anti-diagonals going up-right (by x + y). Bit i of a line
+		// mask is the i-th cell of the line from its left end (its top end for columns).
+		inline unsigned int LineCount() const { return 6 * size - 2; }
+		unsigned int LineLength(unsigned int line) const;
+		Coord LineCell(unsigned int line, unsigned int index) const;
+		inline uint16_t LineMask(unsigned int line, TileState side) const { return lines[line][side == TileState::Cross ? 1 : 0]; }
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "game_record.hpp"
+#include "../core/log.hpp"
+#include <cstring>
+
+#ifndef __SWITCH__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ttt {
+	void GameRecord::Reset(const Board& board, bool crossFirst, uint8_t circleSolver, uint8_t crossSolver) {
+		size = static_cast<uint8_t>(board.Size());
+		winLength = static_cast<uint8_t>(board.WinLength());
+		result = BoardState::Regular;
+		this->crossFirst = crossFirst;
+		this->circleSolver = circleSolver;
+		this->crossSolver = crossSolver;
+		moveCount = 0;
+	}
+
+	GameRecordWriter::GameRecordWriter() : file(nullptr), blockSize(0), gameCount(0), gamesWritten(0) {
+
+	}
+
+	bool GameRecordWriter::Open(const char* path, uint32_t blockSize) {
+		if (file != nullptr) {
+			return false;
+		}
+
+		// The largest possible game has to fit a block
+		uint32_t minBlockSize = sizeof(GameRecordBlockHeader) + sizeof(GameRecordGameHeader) + Board::MaxSize * Board::MaxSize;
+		if (blockSize < minBlockSize) {
+			blockSize = minBlockSize;
+		}
+
+		file = fopen(path, "ab");
+		if (file == nullptr) {
+			LOG_ERROR("REC", "Failed to open %s", path);
+			return false;
+		}
+
+		fseek(file, 0, SEEK_END);
+		if (ftell(file) == 0) {
+			GameRecordFileHeader header { GameRecordMagic, GameRecordVersion, 0, blockSize, 0 };
+			fwrite(&header, sizeof(header), 1, file);
+		}
+
+		this->blockSize = blockSize;
+		block.clear();
+		block.reserve(blockSize);
+		block.resize(sizeof(GameRecordBlockHeader));
+		gameCount = 0;
+		gamesWritten = 0;
+		return true;
+	}
+
+	bool GameRecordWriter::Append(const GameRecord& game) {
+		if (file == nullptr) {
+			return false;
+		}
+
+		size_t encoded = sizeof(GameRecordGameHeader) + PackedMovesBytes(game.moveCount, game.size);
+		if (block.size() + encoded > blockSize && !FlushBlock()) {
+			return false;
+		}
+
+		GameRecordGameHeader header {
+			game.size,
+			game.winLength,
+			static_cast<uint8_t>(game.result),
+			static_cast<uint8_t>(game.crossFirst ? GameFlag_CrossFirst : 0),
+			game.moveCount,
+			game.circleSolver,
+			game.crossSolver,
+			0
+		};
+
+		size_t offset = block.size();
+		block.resize(offset + encoded, 0);
+		std::memcpy(&block[offset], &header, sizeof(header));
+
+		uint8_t* packed = &block[offset + sizeof(header)];
+		unsigned int bits = MoveBits(game.size);
+		for (unsigned int i = 0; i < game.moveCount; i++) {
+			unsigned int bit = i * bits;
+			unsigned int value = static_cast<unsigned int>(game.moves[i]) << (bit % 8);
+			packed[bit / 8] |= static_cast<uint8_t>(value);
+			if ((bit % 8) + bits > 8) {
+				packed[bit / 8 + 1] |= static_cast<uint8_t>(value >> 8);
+			}
+		}
+
+		gameCount++;
+		gamesWritten++;
+		return true;
+	}
+
+	bool GameRecordWriter::FlushBlock() {
+		if (gameCount == 0) {
+			return true;
+		}
+
+		GameRecordBlockHeader header { GameRecordBlockMagic, static_cast<uint32_t>(block.size() - sizeof(GameRecordBlockHeader)), gameCount };
+		std::memcpy(&block[0], &header, sizeof(header));
+
+		bool ok = fwrite(&block[0], 1, block.size(), file) == block.size();
+		if (!ok) {
+			LOG_ERROR("REC", "Failed to write a block of %u games", gameCount);
+		}
+
+		block.resize(sizeof(GameRecordBlockHeader));
+		gameCount = 0;
+		return ok;
+	}
+
+	bool GameRecordWriter::Flush() {
+		if (file == nullptr) {
+			return false;
+		}
+
+		bool ok = FlushBlock();
+		fflush(file);
+		return ok;
+	}
+
+	void GameRecordWriter::Close() {
+		if (file != nullptr) {
+			FlushBlock();
+			fclose(file);
+			file = nullptr;
+		}
+	}
+
+	GameRecordWriter::~GameRecordWriter() {
+		Close();
+	}
+
+	void GameRecordStats::Add(const GameView& game) {
+		games++;
+		moves += game.MoveCount();
+		switch (game.Result()) {
+			case BoardState::CircleWin:
+				circleWins++;
+				break;
+			case BoardState::CrossWin:
+				crossWins++;
+				break;
+			case BoardState::Tied:
+				ties++;
+				break;
+			default:
+				break;
+		}
+	}
+
+	void GameRecordStats::Merge(const GameRecordStats& other) {
+		games += other.games;
+		circleWins += other.circleWins;
+		crossWins += other.crossWins;
+		ties += other.ties;
+		moves += other.moves;
+	}
+
+	GameRecordReader::GameRecordReader() : data(nullptr), size(0), mapped(false), gameCount(0) {
+
+	}
+
+	bool GameRecordReader::Open(const char* path) {
+		if (data != nullptr) {
+			return false;
+		}
+
+#ifndef __SWITCH__
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			LOG_ERROR("REC", "Failed to open %s", path);
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map != MAP_FAILED) {
+				data = static_cast<const uint8_t*>(map);
+				size = info.st_size;
+				mapped = true;
+				madvise(map, size, MADV_SEQUENTIAL);
+			}
+		}
+		close(fd);
+#endif
+
+		if (data == nullptr) {
+			// No mmap available (or it failed), read the file in one go instead
+			FILE* file = fopen(path, "rb");
+			if (file == nullptr) {
+				LOG_ERROR("REC", "Failed to open %s", path);
+				return false;
+			}
+
+			fseek(file, 0, SEEK_END);
+			long length = ftell(file);
+			fseek(file, 0, SEEK_SET);
+			if (length > 0) {
+				fallback.resize(length);
+				if (fread(&fallback[0], 1, length, file) != static_cast<size_t>(length)) {
+					fallback.clear();
+				}
+			}
+			fclose(file);
+
+			if (fallback.empty()) {
+				LOG_ERROR("REC", "Failed to read %s", path);
+				return false;
+			}
+			data = &fallback[0];
+			size = fallback.size();
+		}
+
+		GameRecordFileHeader header;
+		if (size < sizeof(header)) {
+			Close();
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (header.magic != GameRecordMagic || header.version != GameRecordVersion) {
+			LOG_ERROR("REC", "%s is not a version %u game record file", path, GameRecordVersion);
+			Close();
+			return false;
+		}
+
+		// Index the blocks, games are only decoded on demand
+		size_t offset = sizeof(header);
+		while (offset + sizeof(GameRecordBlockHeader) <= size) {
+			GameRecordBlockHeader blockHeader;
+			std::memcpy(&blockHeader, data + offset, sizeof(blockHeader));
+			offset += sizeof(blockHeader);
+
+			if (blockHeader.magic != GameRecordBlockMagic || offset + blockHeader.payloadBytes > size) {
+				LOG_WARN("REC", "%s: truncated or corrupted block at offset %zu", path, offset - sizeof(blockHeader));
+				break;
+			}
+
+			blocks.push_back(BlockSpan { data + offset, blockHeader.payloadBytes, blockHeader.gameCount });
+			gameCount += blockHeader.gameCount;
+			offset += blockHeader.payloadBytes;
+		}
+
+		return true;
+	}
+
+	void GameRecordReader::Close() {
+#ifndef __SWITCH__
+		if (mapped && data != nullptr) {
+			munmap(const_cast<uint8_t*>(data), size);
+		}
+#endif
+		data = nullptr;
+		size = 0;
+		mapped = false;
+		fallback.clear();
+		fallback.shrink_to_fit();
+		blocks.clear();
+		gameCount = 0;
+	}
+
+	GameRecordStats GameRecordReader::ComputeStats(core::JobSystem& jobs) const {
+		std::vector<GameRecordStats> perWorker(jobs.WorkerCount(), GameRecordStats {});
+		ParallelForEachGame(jobs, [&perWorker](unsigned int worker, const GameView& game) {
+			perWorker[worker].Add(game);
+		});
+
+		GameRecordStats total {};
+		for (const auto& stats : perWorker) {
+			total.Merge(stats);
+		}
+		return total;
+	}
+
+	GameRecordReader::~GameRecordReader() {
+		Close();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#pragma once
+#include "board.hpp"
+#include "../core/job_system.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Binary game records
+//
+// File:  FileHeader, then blocks until the end of the file.
+// Block: BlockHeader, then gameCount games in payloadBytes bytes. A game never straddles two
+//        blocks, so blocks can be decoded independently (and in parallel).
+// Game:  GameHeader, then moveCount cell indices (y * size + x) packed LSB first with
+//        MoveBits(size) bits each: 4 bits on 3x3, 7 bits on 9x9, 8 bits on 15x15.
+//
+// All integers are little-endian.
+
+namespace ttt {
+	constexpr uint32_t GameRecordMagic = 0x52545454;	// "TTTR"
+	constexpr uint32_t GameRecordBlockMagic = 0x4B4C4254;	// "TBLK"
+	constexpr uint16_t GameRecordVersion = 1;
+
+	struct GameRecordFileHeader {
+		uint32_t magic;
+		uint16_t version;
+		uint16_t flags;
+		uint32_t blockSize;
+		uint32_t reserved;
+	};
+
+	struct GameRecordBlockHeader {
+		uint32_t magic;
+		uint32_t payloadBytes;
+		uint32_t gameCount;
+	};
+
+	struct GameRecordGameHeader {
+		uint8_t size;
+		uint8_t winLength;
+		uint8_t result;			// BoardState
+		uint8_t flags;			// GameFlag_*
+		uint8_t moveCount;
+		uint8_t circleSolver;	// Application defined strategy ids
+		uint8_t crossSolver;
+		uint8_t reserved;
+	};
+
+	enum GameFlags : uint8_t {
+		GameFlag_CrossFirst = 1 << 0
+	};
+
+	static_assert(sizeof(GameRecordFileHeader) == 16, "Unexpected file header layout");
+	static_assert(sizeof(GameRecordBlockHeader) == 12, "Unexpected block header layout");
+	static_assert(sizeof(GameRecordGameHeader) == 8, "Unexpected game header layout");
+
+	// Bits needed to store a cell index of a size x size board
+	inline unsigned int MoveBits(unsigned int size) {
+		unsigned int cells = size * size;
+		unsigned int bits = 1;
+		while ((1u << bits) < cells) {
+			bits++;
+		}
+		return bits;
+	}
+
+	inline size_t PackedMovesBytes(unsigned int moveCount, unsigned int size) {
+		return (moveCount * MoveBits(size) + 7) / 8;
+	}
+
+	// A game to be written
+	struct GameRecord {
+		uint8_t size;
+		uint8_t winLength;
+		BoardState result;
+		bool crossFirst;
+		uint8_t circleSolver;
+		uint8_t crossSolver;
+		uint8_t moveCount;
+		uint8_t moves[Board::MaxSize * Board::MaxSize];
+
+		void Reset(const Board& board, bool crossFirst, uint8_t circleSolver = 0, uint8_t crossSolver = 0);
+		inline void Add(Coord move) { moves[moveCount++] = static_cast<uint8_t>(move.y * size + move.x); }
+	};
+
+	// Zero-copy view of a game inside a mapped record file
+	class GameView {
+	protected:
+		const GameRecordGameHeader* header;
+		const uint8_t* packed;
+		unsigned int bits;
+	public:
+		GameView() : header(nullptr), packed(nullptr), bits(0) {}
+		GameView(const GameRecordGameHeader* header) : header(header), packed(reinterpret_cast<const uint8_t*>(header + 1)), bits(MoveBits(header->size)) {}
+
+		inline unsigned int Size() const { return header->size; }
+		inline unsigned int WinLength() const { return header->winLength; }
+		inline BoardState Result() const { return static_cast<BoardState>(header->result); }
+		inline bool CrossFirst() const { return (header->flags & GameFlag_CrossFirst) != 0; }
+		inline unsigned int MoveCount() const { return header->moveCount; }
+		inline uint8_t CircleSolver() const { return header->circleSolver; }
+		inline uint8_t CrossSolver() const { return header->crossSolver; }
+
+		inline unsigned int CellIndex(unsigned int i) const {
+			unsigned int bit = i * bits;
+			unsigned int value = packed[bit / 8];
+			if ((bit % 8) + bits > 8) {
+				value |= static_cast<unsigned int>(packed[bit / 8 + 1]) << 8;
+			}
+			return (value >> (bit % 8)) & ((1u << bits) - 1);
+		}
+
+		inline Coord Move(unsigned int i) const {
+			unsigned int cell = CellIndex(i);
+			return Coord { cell % header->size, cell / header->size };
+		}
+
+		inline size_t EncodedBytes() const { return sizeof(GameRecordGameHeader) + PackedMovesBytes(header->moveCount, header->size); }
+	};
+
+	// Append-only buffered writer. Games are collected in a block-sized buffer and written a
+	// whole block at a time, an existing file is appended to.
+	class GameRecordWriter {
+	protected:
+		FILE* file;
+		uint32_t blockSize;
+		std::vector<uint8_t> block;
+		uint32_t gameCount;
+		uint64_t gamesWritten;
+
+		bool FlushBlock();
+	public:
+		GameRecordWriter();
+		GameRecordWriter(const GameRecordWriter&) = delete;
+		GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+		bool Open(const char* path, uint32_t blockSize = 64 * 1024);
+		bool Append(const GameRecord& game);
+		bool Flush();
+		void Close();
+
+		inline bool IsOpen() const { return file != nullptr; }
+		inline uint64_t GamesWritten() const { return gamesWritten; }
+
+		~GameRecordWriter();
+	};
+
+	struct GameRecordStats {
+		uint64_t games;
+		uint64_t circleWins;
+		uint64_t crossWins;
+		uint64_t ties;
+		uint64_t moves;
+
+		void Add(const GameView& game);
+		void Merge(const GameRecordStats& other);
+	};
+
+	// Maps a record file (mmap on hosts, a single read where mmap is not available) and walks its
+	// games in place, without allocating anything per game.
+	class GameRecordReader {
+	protected:
+		struct BlockSpan {
+			const uint8_t* begin;
+			uint32_t payloadBytes;
+			uint32_t gameCount;
+		};
+
+		const uint8_t* data;
+		size_t size;
+		bool mapped;
+		std::vector<uint8_t> fallback;
+		std::vector<BlockSpan> blocks;
+		uint64_t gameCount;
+
+		template<typename Fn>
+		static void ForEachInBlock(const BlockSpan& block, Fn& fn) {
+			const uint8_t* ptr = block.begin;
+			const uint8_t* end = block.begin + block.payloadBytes;
+			for (uint32_t i = 0; i < block.gameCount && ptr + sizeof(GameRecordGameHeader) <= end; i++) {
+				GameView game(reinterpret_cast<const GameRecordGameHeader*>(ptr));
+				if (ptr + game.EncodedBytes() > end) {
+					return;
+				}
+				fn(game);
+				ptr += game.EncodedBytes();
+			}
+		}
+	public:
+		GameRecordReader();
+		GameRecordReader(const GameRecordReader&) = delete;
+		GameRecordReader& operator=(const GameRecordReader&) = delete;
+
+		bool Open(const char* path);
+		void Close();
+
+		inline uint64_t GameCount() const { return gameCount; }
+		inline size_t BlockCount() const { return blocks.size(); }
+
+		// fn(const GameView&) is called for every game, in file order
+		template<typename Fn>
+		void ForEachGame(Fn fn) const {
+			for (const BlockSpan& block : blocks) {
+				ForEachInBlock(block, fn);
+			}
+		}
+
+		// Spreads the blocks over the workers of jobs, fn(unsigned int worker, const GameView&) is
+		// called concurrently from every worker (worker is JobSystem::CurrentWorker(), below
+		// jobs.WorkerCount()), games of a block stay on the same worker. Must be called by a
+		// worker of jobs.
+		template<typename Fn>
+		void ParallelForEachGame(core::JobSystem& jobs, Fn fn) const {
+			jobs.ParallelFor(static_cast<uint32_t>(blocks.size()), 1, [this, &jobs, &fn](uint32_t begin, uint32_t end) {
+				unsigned int worker = jobs.CurrentWorker();
+				auto perGame = [worker, &fn](const GameView& game) { fn(worker, game); };
+				for (uint32_t b = begin; b < end; b++) {
+					ForEachInBlock(blocks[b], perGame);
+				}
+			});
+		}
+
+		// Aggregate statistics of the whole file, computed with ParallelForEachGame
+		GameRecordStats ComputeStats(core::JobSystem& jobs) const;
+
+		~GameRecordReader();
+	};
+}
\ No newline at end of file
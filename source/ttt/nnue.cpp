@@ -0,0 +1,242 @@
+#include "nnue.hpp"
+#include "search.hpp"
+#include "../core/log.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TTT_NNUE_NEON
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define TTT_NNUE_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TTT_NNUE_SSE2
+#endif
+
+namespace ttt {
+	namespace {
+		// accumulator[i] += row[i] (or -=) over NnueHidden values, both 32-byte aligned
+		template<bool add>
+		inline void UpdateRow(int16_t* accumulator, const int16_t* row) {
+#if defined(TTT_NNUE_NEON)
+			for (unsigned int i = 0; i < NnueHidden; i += 8) {
+				int16x8_t a = vld1q_s16(accumulator + i);
+				int16x8_t w = vld1q_s16(row + i);
+				vst1q_s16(accumulator + i, add ? vaddq_s16(a, w) : vsubq_s16(a, w));
+			}
+#elif defined(TTT_NNUE_AVX2)
+			for (unsigned int i = 0; i < NnueHidden; i += 16) {
+				__m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(accumulator + i));
+				__m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i));
+				_mm256_store_si256(reinterpret_cast<__m256i*>(accumulator + i), add ? _mm256_add_epi16(a, w) : _mm256_sub_epi16(a, w));
+			}
+#elif defined(TTT_NNUE_SSE2)
+			for (unsigned int i = 0; i < NnueHidden; i += 8) {
+				__m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(accumulator + i));
+				__m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(row + i));
+				_mm_store_si128(reinterpret_cast<__m128i*>(accumulator + i), add ? _mm_add_epi16(a, w) : _mm_sub_epi16(a, w));
+			}
+#else
+			for (unsigned int i = 0; i < NnueHidden; i++) {
+				accumulator[i] = static_cast<int16_t>(add ? accumulator[i] + row[i] : accumulator[i] - row[i]);
+			}
+#endif
+		}
+
+		// out[i] = clamp(in[i], 0, NnueActivationOne) over NnueHidden values
+		inline void ClippedRelu(const int16_t* in, uint8_t* out) {
+#if defined(TTT_NNUE_NEON)
+			for (unsigned int i = 0; i < NnueHidden; i += 16) {
+				uint8x16_t packed = vcombine_u8(vqmovun_s16(vld1q_s16(in + i)), vqmovun_s16(vld1q_s16(in + i + 8)));
+				vst1q_u8(out + i, vminq_u8(packed, vdupq_n_u8(NnueActivationOne)));
+			}
+#elif defined(TTT_NNUE_AVX2)
+			__m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(in));
+			__m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + 16));
+			// packs works within 128-bit lanes, the permute puts the values back in order
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_max_epi8(packed, _mm256_setzero_si256()));
+#elif defined(TTT_NNUE_SSE2)
+			__m128i zero = _mm_setzero_si128();
+			for (unsigned int i = 0; i < NnueHidden; i += 16) {
+				__m128i a = _mm_max_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(in + i)), zero);
+				__m128i b = _mm_max_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(in + i + 8)), zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi16(a, b));
+			}
+#else
+			for (unsigned int i = 0; i < NnueHidden; i++) {
+				out[i] = static_cast<uint8_t>(std::min<int>(std::max<int>(in[i], 0), NnueActivationOne));
+			}
+#endif
+		}
+
+		// Dot product of 2 * NnueHidden activations in [0, 127] with int8 weights. Pairs of
+		// products fit an int16 (2 * 127 * 127 < 32768), which is what maddubs relies on.
+		inline int32_t Dot(const uint8_t* activations, const int8_t* weights) {
+			constexpr unsigned int count = 2 * NnueHidden;
+#if defined(TTT_NNUE_NEON)
+			int32x4_t sum = vdupq_n_s32(0);
+			for (unsigned int i = 0; i < count; i += 16) {
+				int8x16_t a = vreinterpretq_s8_u8(vld1q_u8(activations + i));
+				int8x16_t w = vld1q_s8(weights + i);
+				int16x8_t products = vmull_s8(vget_low_s8(a), vget_low_s8(w));
+				products = vmlal_s8(products, vget_high_s8(a), vget_high_s8(w));
+				sum = vpadalq_s16(sum, products);
+			}
+			return vaddvq_s32(sum);
+#elif defined(TTT_NNUE_AVX2)
+			__m256i ones = _mm256_set1_epi16(1);
+			__m256i sum = _mm256_setzero_si256();
+			for (unsigned int i = 0; i < count; i += 32) {
+				__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(activations + i));
+				__m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+				sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones));
+			}
+			__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+			half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+			half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+			return _mm_cvtsi128_si32(half);
+#elif defined(TTT_NNUE_SSE2)
+			__m128i zero = _mm_setzero_si128();
+			__m128i sum = zero;
+			for (unsigned int i = 0; i < count; i += 16) {
+				__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(activations + i));
+				__m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i));
+				// Widen to int16: activations are unsigned, weights are sign-extended
+				__m128i aLow = _mm_unpacklo_epi8(a, zero);
+				__m128i aHigh = _mm_unpackhi_epi8(a, zero);
+				__m128i wLow = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+				__m128i wHigh = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(aLow, wLow));
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(aHigh, wHigh));
+			}
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+			return _mm_cvtsi128_si32(sum);
+#else
+			int32_t sum = 0;
+			for (unsigned int i = 0; i < count; i++) {
+				sum += static_cast<int32_t>(activations[i]) * weights[i];
+			}
+			return sum;
+#endif
+		}
+
+		// Reads count little-endian values of T, false past the end of the data
+		template<typename T>
+		bool Read(const uint8_t*& data, const uint8_t* end, T* out, size_t count) {
+			size_t bytes = sizeof(T) * count;
+			if (static_cast<size_t>(end - data) < bytes) {
+				return false;
+			}
+			memcpy(out, data, bytes);
+			data += bytes;
+			return true;
+		}
+	}
+
+	NnueNetwork::NnueNetwork() : size(0), winLength(0), cells(0), evalScale(0), loaded(false), featureBias(), hiddenWeights(), hiddenBias(), outputWeights(), outputBias(0) {
+
+	}
+
+	bool NnueNetwork::Load(const uint8_t* data, size_t bytes) {
+		loaded = false;
+		const uint8_t* end = data + bytes;
+
+		NnueFileHeader header;
+		if (!Read(data, end, &header, 1) || header.magic != NnueMagic || header.version != NnueVersion) {
+			LOG_ERROR("NNUE", "Not a network file");
+			return false;
+		}
+		if (header.hidden != NnueHidden || header.layer != NnueLayer || header.size < 1 || header.size > Board::MaxSize) {
+			LOG_ERROR("NNUE", "Unsupported network: %ux%u, %u/%u neurons", header.size, header.size, header.hidden, header.layer);
+			return false;
+		}
+
+		size = header.size;
+		winLength = header.winLength;
+		cells = size * size;
+		evalScale = header.evalScale;
+		featureWeights.reset(new FeatureRow[2 * cells]);
+
+		bool complete = Read(data, end, featureBias, NnueHidden);
+		for (unsigned int i = 0; i < 2 * cells && complete; i++) {
+			complete = Read(data, end, featureWeights[i].weights, NnueHidden);
+		}
+		complete = complete && Read(data, end, hiddenBias, NnueLayer) && Read(data, end, &hiddenWeights[0][0], NnueLayer * 2 * NnueHidden) &&
+			Read(data, end, &outputBias, 1) && Read(data, end, outputWeights, NnueLayer);
+		if (!complete) {
+			LOG_ERROR("NNUE", "Truncated network file");
+			featureWeights = nullptr;
+			return false;
+		}
+
+		loaded = true;
+		LOG_INFO("NNUE", "Loaded network for %ux%u, k = %u", size, size, winLength);
+		return true;
+	}
+
+	bool NnueNetwork::LoadFile(const char* path) {
+		FILE* file = fopen(path, "rb");
+		if (file == nullptr) {
+			LOG_ERROR("NNUE", "Failed to open %s", path);
+			return false;
+		}
+
+		std::vector<uint8_t> data;
+		uint8_t chunk[4096];
+		size_t read;
+		while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+			data.insert(data.end(), chunk, chunk + read);
+		}
+		fclose(file);
+
+		return Load(data.data(), data.size());
+	}
+
+	void NnueNetwork::Refresh(const Board& board, NnueAccumulator& accumulator) const {
+		for (unsigned int p = 0; p < 2; p++) {
+			memcpy(accumulator.values[p], featureBias, sizeof(featureBias));
+		}
+
+		for (unsigned int y = 0; y < size; y++) {
+			for (unsigned int x = 0; x < size; x++) {
+				TileState tile = board.Get(x, y);
+				if (tile == TileState::Circle || tile == TileState::Cross) {
+					Add(accumulator, x, y, tile);
+				}
+			}
+		}
+	}
+
+	void NnueNetwork::Add(NnueAccumulator& accumulator, unsigned int x, unsigned int y, TileState tile) const {
+		UpdateRow<true>(accumulator.values[0], featureWeights[Feature(TileState::Circle, x, y, tile)].weights);
+		UpdateRow<true>(accumulator.values[1], featureWeights[Feature(TileState::Cross, x, y, tile)].weights);
+	}
+
+	void NnueNetwork::Remove(NnueAccumulator& accumulator, unsigned int x, unsigned int y, TileState tile) const {
+		UpdateRow<false>(accumulator.values[0], featureWeights[Feature(TileState::Circle, x, y, tile)].weights);
+		UpdateRow<false>(accumulator.values[1], featureWeights[Feature(TileState::Cross, x, y, tile)].weights);
+	}
+
+	int NnueNetwork::Evaluate(const NnueAccumulator& accumulator, TileState side) const {
+		// The side to move's perspective comes first
+		unsigned int own = side == TileState::Circle ? 0 : 1;
+		alignas(32) uint8_t input[2 * NnueHidden];
+		ClippedRelu(accumulator.values[own], input);
+		ClippedRelu(accumulator.values[1 - own], input + NnueHidden);
+
+		int32_t output = outputBias;
+		for (unsigned int i = 0; i < NnueLayer; i++) {
+			int32_t hidden = (Dot(input, hiddenWeights[i]) + hiddenBias[i]) / NnueWeightScale;
+			output += std::min<int32_t>(std::max<int32_t>(hidden, 0), NnueActivationOne) * outputWeights[i];
+		}
+
+		int64_t score = static_cast<int64_t>(output) * evalScale / (NnueActivationOne * NnueWeightScale);
+		return static_cast<int>(std::min<int64_t>(std::max<int64_t>(score, -(WinThreshold - 1)), WinThreshold - 1));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+#include "board.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Quantized evaluation network (NNUE) weight file
+//
+// File: NnueFileHeader, then the layers in evaluation order:
+//   int16 featureBias[NnueHidden]
+//   int16 featureWeights[2 * size * size][NnueHidden]
+//   int32 hiddenBias[NnueLayer]
+//   int8  hiddenWeights[NnueLayer][2 * NnueHidden]
+//   int32 outputBias
+//   int8  outputWeights[NnueLayer]
+// All integers are little-endian. About 7.5 KB for 7x7, small enough to embed in the binary.
+
+namespace ttt {
+	constexpr uint32_t NnueMagic = 0x4E545454;	// "TTTN"
+	constexpr uint16_t NnueVersion = 1;
+
+	// Accumulator width per perspective, and width of the hidden layer
+	constexpr unsigned int NnueHidden = 32;
+	constexpr unsigned int NnueLayer = 16;
+	// Quantization: activations are clipped to [0, NnueActivationOne] (1.0), dense weights are
+	// scaled by NnueWeightScale
+	constexpr int NnueActivationOne = 127;
+	constexpr int NnueWeightScale = 64;
+
+	struct NnueFileHeader {
+		uint32_t magic;
+		uint16_t version;
+		uint8_t size;
+		uint8_t winLength;
+		uint16_t hidden;
+		uint16_t layer;
+		// Search score of a network output of 1.0
+		int32_t evalScale;
+	};
+
+	static_assert(sizeof(NnueFileHeader) == 16, "Unexpected network header layout");
+
+	// First layer outputs of both perspectives, [0] Circle and [1] Cross
+	struct alignas(32) NnueAccumulator {
+		int16_t values[2][NnueHidden];
+	};
+
+	// Small quantized network evaluating k-in-a-row positions, trained offline on self-play
+	// records (tools/nnue_trainer.cpp) for one board size and win length.
+	// Inputs are one feature per (cell, own or opponent tile) from each side's perspective. The
+	// first layer is linear in them, so its outputs are kept in an NnueAccumulator updated with
+	// one row of weights per placed or removed tile, and an evaluation only runs the two small
+	// dense layers on top. The kernels use NEON on the console and SSE2 or AVX2 on hosts
+	// (depending on the compiler flags), with a scalar fallback.
+	class NnueNetwork {
+	protected:
+		struct alignas(32) FeatureRow {
+			int16_t weights[NnueHidden];
+		};
+
+		unsigned int size;
+		unsigned int winLength;
+		unsigned int cells;
+		int32_t evalScale;
+		bool loaded;
+
+		alignas(32) int16_t featureBias[NnueHidden];
+		std::unique_ptr<FeatureRow[]> featureWeights;
+		alignas(32) int8_t hiddenWeights[NnueLayer][2 * NnueHidden];
+		alignas(32) int32_t hiddenBias[NnueLayer];
+		alignas(32) int8_t outputWeights[NnueLayer];
+		int32_t outputBias;
+
+		inline unsigned int Feature(TileState perspective, unsigned int x, unsigned int y, TileState tile) const {
+			return (tile == perspective ? 0 : cells) + y * size + x;
+		}
+	public:
+		NnueNetwork();
+		NnueNetwork(const NnueNetwork&) = delete;
+		NnueNetwork& operator=(const NnueNetwork&) = delete;
+
+		// Loads a weight file from memory (an embedded blob or a file read), false if it is
+		// malformed or truncated
+		bool Load(const uint8_t* data, size_t bytes);
+		bool LoadFile(const char* path);
+
+		inline bool IsLoaded() const { return loaded; }
+		// Whether the network was trained for the dimensions of board
+		inline bool Matches(const Board& board) const { return loaded && board.Size() == size && board.WinLength() == winLength; }
+
+		// Recomputes accumulator from scratch
+		void Refresh(const Board& board, NnueAccumulator& accumulator) const;
+		// Incremental updates for a tile placed on or removed from x, y
+		void Add(NnueAccumulator& accumulator, unsigned int x, unsigned int y, TileState tile) const;
+		void Remove(NnueAccumulator& accumulator, unsigned int x, unsigned int y, TileState tile) const;
+
+		// Score of the position for side, in search units (see search.hpp), never a win score
+		int Evaluate(const NnueAccumulator& accumulator, TileState side) const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "patterns.hpp"
+#include <algorithm>
+
+namespace ttt {
+	namespace {
+		// Base-3 digits of every mask of MaxTableLength bits
+		struct Base3Table {
+			uint16_t values[1 << PatternTable::MaxTableLength];
+
+			Base3Table() {
+				for (uint32_t mask = 0; mask < (1u << PatternTable::MaxTableLength); mask++) {
+					uint16_t value = 0;
+					uint16_t digit = 1;
+					for (unsigned int i = 0; i < PatternTable::MaxTableLength; i++, digit *= 3) {
+						if (mask & (1u << i)) {
+							value += digit;
+						}
+					}
+					values[mask] = value;
+				}
+			}
+		};
+
+		const Base3Table base3Table;
+
+		Threat ThreatOf(unsigned int tiles, unsigned int winLength) {
+			if (tiles == 0) {
+				return Threat::None;
+			}
+
+			switch (winLength - tiles) {
+				case 0:
+					return Threat::Win;
+				case 1:
+					return Threat::Four;
+				case 2:
+					return Threat::Three;
+				case 3:
+					return Threat::Two;
+				default:
+					return Threat::None;
+			}
+		}
+	}
+
+	PatternTable::PatternTable() : winLength(0) {
+
+	}
+
+	uint16_t PatternTable::Base3(uint32_t mask) {
+		return base3Table.values[mask];
+	}
+
+	Pattern PatternTable::Classify(uint32_t circle, uint32_t cross, unsigned int winLength) {
+		Pattern pattern { 0, Threat::None, Threat::None, 0 };
+		if (circle != 0 && cross != 0) {
+			// Blocked for both sides
+			return pattern;
+		}
+
+		uint32_t own = circle != 0 ? circle : cross;
+		unsigned int tiles = static_cast<unsigned int>(__builtin_popcount(own));
+		Threat threat = ThreatOf(tiles, winLength);
+
+		// Every tile multiplies the value of a window by 8
+		int32_t score = tiles > 0 ? static_cast<int32_t>(1) << std::min(3 * (tiles - 1), 30u) : 0;
+		if (circle != 0) {
+			pattern.score = score;
+			pattern.circle = threat;
+		} else {
+			pattern.score = -score;
+			pattern.cross = threat;
+		}
+
+		if (threat == Threat::Four) {
+			uint32_t empty = ~own & ((1u << winLength) - 1);
+			pattern.completion = static_cast<uint8_t>(__builtin_ctz(empty));
+		}
+		return pattern;
+	}
+
+	void PatternTable::Build(unsigned int winLength) {
+		this->winLength = winLength;
+		if (winLength > MaxTableLength) {
+			return;
+		}
+
+		unsigned int windows = 1;
+		for (unsigned int i = 0; i < winLength; i++) {
+			windows *= 3;
+		}
+
+		// Only codes of disjoint masks are reachable, the others stay zero
+		patterns.reset(new Pattern[windows]());
+		for (uint32_t circle = 0; circle < (1u << winLength); circle++) {
+			for (uint32_t cross = 0; cross < (1u << winLength); cross++) {
+				if ((circle & cross) == 0) {
+					patterns[Base3(circle) + 2 * Base3(cross)] = Classify(circle, cross, winLength);
+				}
+			}
+		}
+	}
+
+	const PatternTable& PatternTable::For(unsigned int winLength) {
+		struct Tables {
+			PatternTable tables[Board::MaxSize + 1];
+
+			Tables() {
+				for (unsigned int k = 1; k <= Board::MaxSize; k++) {
+					tables[k].Build(k);
+				}
+			}
+		};
+
+		static const Tables tables;
+		return tables.tables[std::min(winLength, Board::MaxSize)];
+	}
+
+	bool FindWinningMove(const Board& board, TileState side, Coord& move) {
+		bool found = false;
+		ForEachWindow(board, [&](unsigned int line, unsigned int offset, const Pattern& pattern) {
+			Threat threat = side == TileState::Circle ? pattern.circle : pattern.cross;
+			if (!found && threat == Threat::Four) {
+				move = board.LineCell(line, offset + pattern.completion);
+				found = true;
+			}
+		});
+		return found;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+#include "board.hpp"
+#include <cstdint>
+#include <memory>
+
+namespace ttt {
+	// How close a window of k cells without opponent tiles is to becoming a line, named after
+	// gomoku (k = 5): a Four needs one more tile, a Three two and a Two three. Windows with no
+	// tile of the side at all are None.
+	enum class Threat : uint8_t {
+		None,
+		Two,
+		Three,
+		Four,
+		Win
+	};
+
+	// Everything the engine needs to know about the contents of one k-cell window
+	struct Pattern {
+		// Heuristic value of the window for Circle, the value for Cross is its negation
+		int32_t score;
+		Threat circle;
+		Threat cross;
+		// Offset in the window of the empty cell completing a Four (of either side, both
+		// cannot have one in the same window)
+		uint8_t completion;
+	};
+
+	// Pattern of every possible window of one win length, precomputed and indexed by the
+	// base-3 code of the window contents (sum of 3^i for the Circle tiles, 2 * 3^i for the
+	// Cross tiles). A window is read from the line masks of the board with two shifts, so
+	// threat detection and evaluation are a handful of bit operations and one load per window.
+	// Tables stop at MaxTableLength (3^8 entries), longer windows are classified on the fly.
+	class PatternTable {
+	public:
+		static constexpr unsigned int MaxTableLength = 8;
+	protected:
+		unsigned int winLength;
+		std::unique_ptr<Pattern[]> patterns;
+
+		PatternTable();
+		void Build(unsigned int winLength);
+		static uint16_t Base3(uint32_t mask);
+	public:
+		PatternTable(const PatternTable&) = delete;
+		PatternTable& operator=(const PatternTable&) = delete;
+
+		// Shared table for a win length, built (thread-safely) on first use
+		static const PatternTable& For(unsigned int winLength);
+		// The Pattern of a window from its Circle and Cross bitmasks, what the tables hold
+		static Pattern Classify(uint32_t circle, uint32_t cross, unsigned int winLength);
+
+		inline Pattern Get(uint32_t circle, uint32_t cross) const {
+			if (patterns == nullptr) {
+				return Classify(circle, cross, winLength);
+			}
+			return patterns[Base3(circle) + 2 * Base3(cross)];
+		}
+	};
+
+	// Calls fn(line, offset, pattern) for each window of k cells of every line of board that
+	// holds at least one tile. offset is the position of the window in the line.
+	template<typename Fn>
+	void ForEachWindow(const Board& board, Fn fn) {
+		unsigned int k = board.WinLength();
+		const PatternTable& table = PatternTable::For(k);
+		uint32_t windowMask = (1u << k) - 1;
+
+		for (unsigned int line = 0; line < board.LineCount(); line++) {
+			uint32_t circle = board.LineMask(line, TileState::Circle);
+			uint32_t cross = board.LineMask(line, TileState::Cross);
+			unsigned int length = board.LineLength(line);
+			if ((circle | cross) == 0 || length < k) {
+				continue;
+			}
+
+			for (unsigned int offset = 0; offset + k <= length; offset++) {
+				uint32_t windowCircle = (circle >> offset) & windowMask;
+				uint32_t windowCross = (cross >> offset) & windowMask;
+				if ((windowCircle | windowCross) != 0) {
+					fn(line, offset, table.Get(windowCircle, windowCross));
+				}
+			}
+		}
+	}
+
+	// Finds an empty cell where side completes a line, false when there is none
+	bool FindWinningMove(const Board& board, TileState side, Coord& move);
+}
\ No newline at end of file
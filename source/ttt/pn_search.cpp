@@ -0,0 +1,332 @@
+#include "pn_search.hpp"
+#include "transposition.hpp"
+#include "patterns.hpp"
+#include "../core/trace.hpp"
+#include <algorithm>
+
+namespace ttt {
+	namespace {
+		// How often (in nodes) the deadline and the stop flag are checked
+		constexpr uint64_t TimeCheckInterval = 1024;
+
+		constexpr unsigned int MaxMoves = Board::MaxSize * Board::MaxSize;
+
+		inline Coord UnpackMove(uint8_t move) {
+			return Coord { move % Board::MaxSize, move / Board::MaxSize };
+		}
+
+		inline uint32_t AddCapped(uint32_t a, uint32_t b) {
+			if (a == ProofSearch::Infinity || b == ProofSearch::Infinity) {
+				return ProofSearch::Infinity;
+			}
+			// Only a settled child may make a sum infinite
+			return static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(a) + b, ProofSearch::Infinity - 1));
+		}
+	}
+
+	ProofSearch::ProofSearch(size_t entryCount) : moveStack(new uint8_t[MaxMoves * (MaxMoves + 1)]), attacker(TileState::Circle), attackerKey(0), nodes(0),
+		nodeLimit(0), hasDeadline(false), stop(nullptr), aborted(false) {
+		size_t buckets = 1;
+		while (buckets * 2 * BucketSize <= entryCount) {
+			buckets *= 2;
+		}
+
+		entries.reset(new Entry[buckets * BucketSize]);
+		bucketMask = buckets - 1;
+		Clear();
+	}
+
+	void ProofSearch::Clear() {
+		for (size_t i = 0; i < Size(); i++) {
+			entries[i] = Entry { 0, 1, 1, 0 };
+		}
+	}
+
+	uint64_t ProofSearch::Key(const Board& position, TileState toMove) const {
+		return position.Hash() ^ SideKey(toMove) ^ attackerKey;
+	}
+
+	const ProofSearch::Entry* ProofSearch::Lookup(uint64_t key) const {
+		const Entry* bucket = &entries[(key & bucketMask) * BucketSize];
+		for (unsigned int i = 0; i < BucketSize; i++) {
+			if (bucket[i].key == key && bucket[i].work > 0) {
+				return &bucket[i];
+			}
+		}
+
+		return nullptr;
+	}
+
+	void ProofSearch::Store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work) {
+		Entry* bucket = &entries[(key & bucketMask) * BucketSize];
+		Entry* victim = &bucket[0];
+		for (unsigned int i = 0; i < BucketSize; i++) {
+			if (bucket[i].key == key || bucket[i].work == 0) {
+				victim = &bucket[i];
+				break;
+			}
+			if (bucket[i].work < victim->work) {
+				victim = &bucket[i];
+			}
+		}
+
+		*victim = Entry { key, phi, delta, std::max<uint32_t>(work, 1) };
+	}
+
+	ProofSearch::NodeStatus ProofSearch::Expand(const Board& position, TileState toMove, uint8_t* moves, unsigned int& count, uint8_t& win) const {
+		count = 0;
+		BoardState state = position.GetState();
+		if (state != BoardState::Regular) {
+			// The game ended on the previous move: only a tie is good for the defender
+			bool attackerWon = (state == BoardState::CircleWin && attacker == TileState::Circle) || (state == BoardState::CrossWin && attacker == TileState::Cross);
+			bool achieved = toMove == attacker ? attackerWon : !attackerWon;
+			return achieved ? NodeStatus::Achieved : NodeStatus::Failed;
+		}
+
+		int size = static_cast<int>(position.Size());
+		int center = size - 1;
+		unsigned int threats = 0;
+		uint8_t block = 0;
+		unsigned int keys[MaxMoves];
+
+		// Cells completing a Four of either side, from the pattern tables
+		bool wins[MaxMoves] = {};
+		bool losses[MaxMoves] = {};
+		ForEachWindow(position, [&](unsigned int line, unsigned int offset, const Pattern& pattern) {
+			Threat own = toMove == TileState::Circle ? pattern.circle : pattern.cross;
+			Threat other = toMove == TileState::Circle ? pattern.cross : pattern.circle;
+			if (own == Threat::Four || other == Threat::Four) {
+				Coord c = position.LineCell(line, offset + pattern.completion);
+				(own == Threat::Four ? wins : losses)[c.y * Board::MaxSize + c.x] = true;
+			}
+		});
+
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				if (position.Get(x, y) != TileState::Empty) {
+					continue;
+				}
+
+				uint8_t move = static_cast<uint8_t>(y * Board::MaxSize + x);
+				if (wins[move]) {
+					win = move;
+					return NodeStatus::Achieved;
+				}
+				if (losses[move]) {
+					threats++;
+					block = move;
+				}
+
+				// Cells next to many stones first, then from the center outwards
+				unsigned int neighbors = 0;
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						TileState s = position.Get(x + dx, y + dy);
+						neighbors += s == TileState::Circle || s == TileState::Cross ? 1 : 0;
+					}
+				}
+				int cx = x * 2 - center;
+				int cy = y * 2 - center;
+				unsigned int key = (8 - neighbors) * 64 + static_cast<unsigned int>((cx < 0 ? -cx : cx) + (cy < 0 ? -cy : cy));
+
+				unsigned int j = count++;
+				while (j > 0 && keys[j - 1] > key) {
+					moves[j] = moves[j - 1];
+					keys[j] = keys[j - 1];
+					j--;
+				}
+				moves[j] = move;
+				keys[j] = key;
+			}
+		}
+
+		// Two open wins cannot both be blocked, and with one every other move loses at once.
+		// Either way the block is the only move left.
+		if (threats >= 1) {
+			moves[0] = block;
+			count = 1;
+		}
+		if (threats >= 2) {
+			return NodeStatus::Failed;
+		}
+
+		return NodeStatus::Open;
+	}
+
+	uint32_t ProofSearch::Search(TileState toMove, uint32_t thresholdPhi, uint32_t thresholdDelta, unsigned int ply) {
+		uint64_t key = Key(board, toMove);
+		nodes++;
+		if (nodeLimit > 0 && nodes >= nodeLimit) {
+			aborted = true;
+		}
+		if ((nodes % TimeCheckInterval) == 0) {
+			if ((hasDeadline && Clock::now() >= deadline) || (stop != nullptr && stop->load(std::memory_order_relaxed))) {
+				aborted = true;
+			}
+		}
+
+		uint8_t* moves = &moveStack[ply * MaxMoves];
+		unsigned int count = 0;
+		uint8_t win = 0;
+		NodeStatus status = Expand(board, toMove, moves, count, win);
+		if (status != NodeStatus::Open) {
+			bool achieved = status == NodeStatus::Achieved;
+			Store(key, achieved ? 0 : Infinity, achieved ? Infinity : 0, 1);
+			return 1;
+		}
+
+		// phi(n) = min delta(child), delta(n) = sum phi(child), children unknown to the table
+		// count as a single leaf
+		TileState next = Opponent(toMove);
+		uint64_t childBase = key ^ SideKey(toMove) ^ SideKey(next);
+		uint32_t work = 1;
+		while (true) {
+			uint32_t phi = Infinity;
+			uint32_t delta = 0;
+			uint32_t secondDelta = Infinity;
+			uint32_t bestPhi = 1;
+			unsigned int best = 0;
+			for (unsigned int i = 0; i < count; i++) {
+				Coord c = UnpackMove(moves[i]);
+				const Entry* entry = Lookup(childBase ^ ZobristKey(c.y * Board::MaxSize + c.x, toMove));
+				uint32_t childPhi = entry != nullptr ? entry->phi : 1;
+				uint32_t childDelta = entry != nullptr ? entry->delta : 1;
+
+				if (childDelta < phi) {
+					secondDelta = phi;
+					phi = childDelta;
+					bestPhi = childPhi;
+					best = i;
+				} else if (childDelta < secondDelta) {
+					secondDelta = childDelta;
+				}
+				delta = AddCapped(delta, childPhi);
+			}
+
+			if (phi >= thresholdPhi || delta >= thresholdDelta || aborted) {
+				Store(key, phi, delta, work);
+				return work;
+			}
+
+			// The best child is searched until it stops being the best one, or until the
+			// node reaches one of its own thresholds
+			uint64_t childPhiThreshold = static_cast<uint64_t>(thresholdDelta) - delta + bestPhi;
+			uint32_t childDeltaThreshold = std::min(thresholdPhi, secondDelta == Infinity ? Infinity : secondDelta + 1);
+
+			Coord c = UnpackMove(moves[best]);
+			board.Set(c, toMove);
+			uint32_t childWork = Search(next, static_cast<uint32_t>(std::min<uint64_t>(childPhiThreshold, Infinity)), childDeltaThreshold, ply + 1);
+			board.Unset(c);
+			work = work + childWork < work ? UINT32_MAX : work + childWork;
+		}
+	}
+
+	void ProofSearch::ExtractLine(ProofResult& result) const {
+		Board position = board;
+		TileState toMove = attacker;
+		uint8_t moves[MaxMoves];
+		result.lineLength = 0;
+
+		while (result.lineLength < MaxMoves) {
+			unsigned int count = 0;
+			uint8_t win = 0;
+			NodeStatus status = Expand(position, toMove, moves, count, win);
+			if (status == NodeStatus::Achieved && toMove == attacker && position.GetState() == BoardState::Regular) {
+				result.line[result.lineLength++] = UnpackMove(win);
+				return;
+			}
+			// A defender facing two threats blocks one, the attacker wins with the other
+			bool lost = status == NodeStatus::Failed && toMove != attacker && position.GetState() == BoardState::Regular && count == 1;
+			if (lost) {
+				Coord c = UnpackMove(moves[0]);
+				position.Set(c, toMove);
+				result.line[result.lineLength++] = c;
+				toMove = attacker;
+				continue;
+			}
+			if (status != NodeStatus::Open) {
+				return;
+			}
+
+			// The attacker follows a proven child, the defender the one that took longest to refute
+			TileState next = Opponent(toMove);
+			int chosen = -1;
+			uint32_t longest = 0;
+			for (unsigned int i = 0; i < count; i++) {
+				Coord c = UnpackMove(moves[i]);
+				position.Set(c, toMove);
+				const Entry* entry = Lookup(Key(position, next));
+				position.Unset(c);
+
+				if (entry == nullptr) {
+					continue;
+				}
+				if (toMove == attacker && entry->phi == Infinity) {
+					chosen = static_cast<int>(i);
+					break;
+				}
+				if (toMove != attacker && entry->phi == 0 && entry->work >= longest) {
+					chosen = static_cast<int>(i);
+					longest = entry->work;
+				}
+			}
+
+			if (chosen < 0) {
+				return;
+			}
+
+			Coord c = UnpackMove(moves[chosen]);
+			position.Set(c, toMove);
+			result.line[result.lineLength++] = c;
+			toMove = next;
+		}
+	}
+
+	ProofResult ProofSearch::Prove(const Board& position, TileState side, const ProofLimits& limits) {
+		TRACE_ZONE("ProofSearch::Prove");
+		board = position;
+		attacker = side;
+		attackerKey = side == TileState::Cross ? MixKey(0xA77AC4E5) : MixKey(0xA77AC1C1);
+		nodes = 0;
+		nodeLimit = limits.nodeBudget;
+		hasDeadline = limits.timeBudget.count() > 0;
+		deadline = Clock::now() + limits.timeBudget;
+		stop = limits.stop;
+		aborted = false;
+
+		ProofResult result;
+		result.outcome = ProofOutcome::Unknown;
+		result.lineLength = 0;
+
+		// Restarted from the table when an iteration hits the thresholds, which only happens
+		// when they overflow on huge trees
+		uint32_t phi = 1;
+		uint32_t delta = 1;
+		while (!aborted && phi != 0 && delta != 0) {
+			Search(side, Infinity, Infinity, 0);
+			const Entry* root = Lookup(Key(board, side));
+			if (root == nullptr) {
+				break;
+			}
+			phi = root->phi;
+			delta = root->delta;
+			if (phi == Infinity || delta == Infinity) {
+				break;
+			}
+		}
+
+		// The root is an attacker node, phi is its proof number
+		result.nodes = nodes;
+		result.proofNumber = phi;
+		result.disproofNumber = delta;
+		if (phi == 0) {
+			result.outcome = ProofOutcome::Win;
+			ExtractLine(result);
+		} else if (delta == 0) {
+			result.outcome = ProofOutcome::NoWin;
+		}
+
+		stop = nullptr;
+		return result;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include "board.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace ttt {
+	enum class ProofOutcome : uint8_t {
+		// The budget ran out before the question was settled
+		Unknown,
+		// The side to move can force a win
+		Win,
+		// The opponent can hold at least a draw
+		NoWin
+	};
+
+	struct ProofLimits {
+		// Expanded nodes for the whole proof, 0 disables the limit
+		uint64_t nodeBudget;
+		// Wall-clock budget, 0 disables the limit
+		std::chrono::microseconds timeBudget;
+		// Aborts the proof when set, like the budgets running out. Optional.
+		const std::atomic<bool>* stop = nullptr;
+	};
+
+	struct ProofResult {
+		ProofOutcome outcome;
+		// With Win, the main line of the proof: the attacker's moves alternating with the
+		// defender's longest resistance, ending with the winning move. It stops early if part of
+		// the proof was evicted from the table.
+		Coord line[Board::MaxSize * Board::MaxSize];
+		unsigned int lineLength;
+		uint64_t nodes;
+		// Of the root, how far an Unknown proof got in either direction
+		uint32_t proofNumber;
+		uint32_t disproofNumber;
+	};
+
+	// Depth-first proof-number search (df-pn) answering "can the side to move force a win?" on
+	// boards too large for the exact alpha-beta solver.
+	// The search always expands the most proving node, the one that needs the fewest
+	// leaves to be settled, so narrow forcing lines (threat sequences) are followed long before
+	// quiet alternatives. Every node answered with a threat is reduced to its blocking move, and
+	// positions with an immediate win or a double threat are settled without expanding them.
+	// Proof and disproof numbers live in a fixed-size table (buckets of BucketSize entries,
+	// replacing the one with the smallest subtree), so memory stays bounded however long the
+	// search runs; evicted nodes are simply searched again. The table is kept between calls and
+	// keyed by the attacker as well, so proving a position again, or one from the same game,
+	// starts from the previous numbers.
+	class ProofSearch {
+	public:
+		static constexpr uint32_t Infinity = 0x7FFFFFFF;
+		static constexpr unsigned int BucketSize = 4;
+	protected:
+		struct Entry {
+			uint64_t key;
+			// Proof number of the side to move (attacker) or disproof number (defender)...
+			uint32_t phi;
+			// ...and the other one
+			uint32_t delta;
+			// Nodes expanded below this one, the replacement priority
+			uint32_t work;
+		};
+
+		enum class NodeStatus {
+			Open,
+			// The side to move reaches its goal: an immediate win, or the game is over in its favor
+			Achieved,
+			// The side to move cannot reach its goal anymore
+			Failed
+		};
+
+		typedef std::chrono::steady_clock Clock;
+
+		std::unique_ptr<Entry[]> entries;
+		size_t bucketMask;
+		std::unique_ptr<uint8_t[]> moveStack;
+
+		Board board;
+		TileState attacker;
+		uint64_t attackerKey;
+		uint64_t nodes;
+		uint64_t nodeLimit;
+		Clock::time_point deadline;
+		bool hasDeadline;
+		const std::atomic<bool>* stop;
+		bool aborted;
+
+		inline uint64_t Key(const Board& position, TileState toMove) const;
+		const Entry* Lookup(uint64_t key) const;
+		void Store(uint64_t key, uint32_t phi, uint32_t delta, uint32_t work);
+		// Status of position with toMove to play, fills moves with the moves worth searching when
+		// it is Open, and win with the winning move when it is an immediate win
+		NodeStatus Expand(const Board& position, TileState toMove, uint8_t* moves, unsigned int& count, uint8_t& win) const;
+		// Searches board until its phi reaches thresholdPhi or its delta thresholdDelta, returns
+		// the number of nodes expanded
+		uint32_t Search(TileState toMove, uint32_t thresholdPhi, uint32_t thresholdDelta, unsigned int ply);
+		void ExtractLine(ProofResult& result) const;
+	public:
+		// entryCount is rounded down to a multiple of BucketSize times a power of two
+		explicit ProofSearch(size_t entryCount = 1 << 18);
+		ProofSearch(const ProofSearch&) = delete;
+		ProofSearch& operator=(const ProofSearch&) = delete;
+
+		ProofResult Prove(const Board& position, TileState side, const ProofLimits& limits);
+		// Forgets every proof and disproof number
+		void Clear();
+
+		inline size_t Size() const { return (bucketMask + 1) * BucketSize; }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "ponder.hpp"
+#include "../core/trace.hpp"
+
+namespace ttt {
+	Ponderer::Ponderer(core::JobSystem& jobs, size_t tableEntries) : jobs(jobs), table(tableEntries), root(nullptr), stop(false), engineSide(TileState::Cross),
+		limits(LimitsFor(Difficulty::Perfect)), seed(0), candidateCount(0), hits(0), misses(0) {
+
+	}
+
+	void Ponderer::SearchCandidate(unsigned int index) {
+		Candidate& candidate = candidates[index];
+		if (stop.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		Board board = position;
+		board.Set(candidate.move % Board::MaxSize, candidate.move / Board::MaxSize, Opponent(engineSide));
+		SearchLimits searchLimits = limits;
+		searchLimits.stop = &stop;
+
+		TRACE_ZONE("ttt::Ponder");
+		candidate.result = Search(board, engineSide, searchLimits, seed, &table);
+		// A search cut by Stop() or by its time budget may have stopped short of the depth the
+		// foreground search would reach, so it is not kept
+		candidate.ready = candidate.result.complete;
+	}
+
+	void Ponderer::Halt() {
+		if (root == nullptr) {
+			return;
+		}
+
+		stop.store(true, std::memory_order_relaxed);
+		jobs.Wait(root);
+		root = nullptr;
+		stop.store(false, std::memory_order_relaxed);
+	}
+
+	void Ponderer::Start(const Board& board, TileState side, const SearchLimits& searchLimits, uint32_t searchSeed) {
+		Halt();
+
+		position = board;
+		engineSide = side;
+		limits = searchLimits;
+		limits.stop = nullptr;
+		seed = searchSeed;
+		candidateCount = 0;
+		if (board.GetState() != BoardState::Regular) {
+			return;
+		}
+
+		// The opponent's moves that look best to them are the likely ones, keep the top few
+		TileState opponent = Opponent(side);
+		int scores[MaxCandidates];
+		Board probe = board;
+		for (unsigned int y = 0; y < board.Size(); y++) {
+			for (unsigned int x = 0; x < board.Size(); x++) {
+				if (!probe.Set(x, y, opponent)) {
+					continue;
+				}
+				int score = probe.GetState() == BoardState::Regular ? Evaluate(probe, opponent) : WinScore;
+				probe.Unset(x, y);
+
+				unsigned int j = candidateCount < MaxCandidates ? candidateCount++ : MaxCandidates;
+				while (j > 0 && scores[j - 1] < score) {
+					if (j < MaxCandidates) {
+						candidates[j] = candidates[j - 1];
+						scores[j] = scores[j - 1];
+					}
+					j--;
+				}
+				if (j < MaxCandidates) {
+					candidates[j].move = static_cast<uint8_t>(y * Board::MaxSize + x);
+					candidates[j].key = probe.Hash() ^ ZobristKey(y * Board::MaxSize + x, opponent);
+					candidates[j].ready = false;
+					scores[j] = score;
+				}
+			}
+		}
+
+		if (candidateCount == 0) {
+			return;
+		}
+
+		// Idle workers steal the oldest jobs first, so the likeliest moves are searched first
+		root = jobs.Create([]() {});
+		for (unsigned int i = 0; i < candidateCount; i++) {
+			jobs.Run(jobs.Create([this, i]() { SearchCandidate(i); }, root));
+		}
+		jobs.Run(root);
+	}
+
+	void Ponderer::Stop() {
+		Halt();
+	}
+
+	SearchResult Ponderer::Reply(const Board& board, bool& precomputed) {
+		TRACE_ZONE("ttt::Ponderer::Reply");
+		Halt();
+
+		for (unsigned int i = 0; i < candidateCount; i++) {
+			if (candidates[i].key == board.Hash() && candidates[i].ready) {
+				hits++;
+				precomputed = true;
+				return candidates[i].result;
+			}
+		}
+		candidateCount = 0;
+
+		misses++;
+		precomputed = false;
+		return Search(board, engineSide, limits, seed, &table);
+	}
+
+	void Ponderer::Clear() {
+		Halt();
+		candidateCount = 0;
+		table.Clear();
+	}
+
+	Ponderer::~Ponderer() {
+		Halt();
+	}
+}
\ No newline at end of file
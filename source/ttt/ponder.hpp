@@ -0,0 +1,76 @@
+#pragma once
+#include "board.hpp"
+#include "search.hpp"
+#include "transposition.hpp"
+#include "../core/job_system.hpp"
+#include <atomic>
+#include <cstdint>
+
+namespace ttt {
+	// Searches on the opponent's time.
+	// While the human is to move, jobs on the job system (so on the cores the main thread leaves
+	// free) play each of their likely moves (best first by static evaluation) and search the
+	// engine's reply to it with the engine's own limits, filling a transposition table shared
+	// with the foreground search. When the human commits, Reply() hands back the precomputed
+	// result if that move was covered, and otherwise searches with the warm table.
+	// Only searches that reached their depth limit or a forced result are kept: one cut by its
+	// time budget may have stopped shallower than the foreground search would, so only its
+	// table entries are reused. Pondering therefore never weakens the engine, it only moves
+	// the work.
+	// Start(), Stop(), Reply() and Clear() must be called by the thread that created the job
+	// system, they wait for the running jobs (and help them) before touching the candidates.
+	class Ponderer {
+	public:
+		static constexpr unsigned int MaxCandidates = 16;
+	protected:
+		struct Candidate {
+			uint8_t move;
+			uint64_t key;	// Board::Hash() after the move
+			bool ready;
+			SearchResult result;
+		};
+
+		core::JobSystem& jobs;
+		TranspositionTable table;
+		// Parent of the candidate searches, nullptr when none runs
+		core::Job* root;
+		std::atomic<bool> stop;
+
+		// Position being pondered, the human is to move. Only written while no job runs.
+		Board position;
+		TileState engineSide;
+		SearchLimits limits;
+		uint32_t seed;
+		Candidate candidates[MaxCandidates];
+		unsigned int candidateCount;
+
+		uint64_t hits;
+		uint64_t misses;
+
+		void SearchCandidate(unsigned int index);
+		void Halt();
+	public:
+		explicit Ponderer(core::JobSystem& jobs, size_t tableEntries = 1 << 18);
+		Ponderer(const Ponderer&) = delete;
+		Ponderer& operator=(const Ponderer&) = delete;
+
+		// Starts pondering board, where the opponent of engineSide is to move. Replaces (and
+		// stops) whatever was being pondered.
+		void Start(const Board& board, TileState engineSide, const SearchLimits& limits, uint32_t seed);
+		// Stops the background searches, results found so far are kept for Reply()
+		void Stop();
+
+		// Engine move on board, which must be the pondered position plus one opponent move.
+		// precomputed tells whether the result came from the background search. Searches on
+		// the calling thread (with the shared table) when the move was not covered.
+		SearchResult Reply(const Board& board, bool& precomputed);
+
+		// Forgets everything learned, for a new game
+		void Clear();
+
+		inline uint64_t Hits() const { return hits; }
+		inline uint64_t Misses() const { return misses; }
+
+		~Ponderer();
+	};
+}
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "search.hpp"
+#include "nnue.hpp"
+#include "patterns.hpp"
+#include "../core/trace.hpp"
+#include <algorithm>
+#include <random>
+
+namespace ttt {
+	namespace {
+		typedef std::chrono::steady_clock Clock;
+
+		// How often (in nodes) the deadline is checked
+		constexpr uint64_t TimeCheckInterval = 1024;
+
+		constexpr unsigned int MaxMoves = Board::MaxSize * Board::MaxSize;
+
+		inline uint8_t PackMove(unsigned int x, unsigned int y) {
+			return static_cast<uint8_t>(y * Board::MaxSize + x);
+		}
+
+		inline Coord UnpackMove(uint8_t move) {
+			return Coord { move % Board::MaxSize, move / Board::MaxSize };
+		}
+
+		// Distance from the center, smaller is searched first
+		inline unsigned int Centrality(const Board& board, uint8_t move) {
+			Coord c = UnpackMove(move);
+			int center = static_cast<int>(board.Size() - 1);
+			int dx = static_cast<int>(c.x) * 2 - center;
+			int dy = static_cast<int>(c.y) * 2 - center;
+			return static_cast<unsigned int>((dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy));
+		}
+
+		// Empty cells next to an occupied one (every empty cell on 3x3, where the whole board
+		// is relevant), ordered from the center outwards
+		unsigned int GenerateMoves(const Board& board, uint8_t* moves) {
+			unsigned int size = board.Size();
+			unsigned int count = 0;
+
+			if (board.MoveCount() == 0 || size <= 3) {
+				for (unsigned int y = 0; y < size; y++) {
+					for (unsigned int x = 0; x < size; x++) {
+						if (board.Get(x, y) == TileState::Empty) {
+							moves[count++] = PackMove(x, y);
+						}
+					}
+				}
+			} else {
+				for (unsigned int y = 0; y < size; y++) {
+					for (unsigned int x = 0; x < size; x++) {
+						if (board.Get(x, y) != TileState::Empty) {
+							continue;
+						}
+
+						bool near = false;
+						for (int dy = -1; dy <= 1 && !near; dy++) {
+							for (int dx = -1; dx <= 1 && !near; dx++) {
+								TileState s = board.Get(x + dx, y + dy);
+								near = s == TileState::Circle || s == TileState::Cross;
+							}
+						}
+
+						if (near) {
+							moves[count++] = PackMove(x, y);
+						}
+					}
+				}
+			}
+
+			for (unsigned int i = 1; i < count; i++) {
+				uint8_t move = moves[i];
+				unsigned int key = Centrality(board, move);
+				unsigned int j = i;
+				while (j > 0 && Centrality(board, moves[j - 1]) > key) {
+					moves[j] = moves[j - 1];
+					j--;
+				}
+				moves[j] = move;
+			}
+
+			return count;
+		}
+
+		// Moves the table move (if it is one of the generated moves) to the front
+		void PromoteMove(uint8_t* moves, unsigned int count, uint8_t hint) {
+			for (unsigned int i = 1; i < count; i++) {
+				if (moves[i] == hint) {
+					for (unsigned int j = i; j > 0; j--) {
+						moves[j] = moves[j - 1];
+					}
+					moves[0] = hint;
+					return;
+				}
+			}
+		}
+
+		class Searcher {
+		public:
+			Board board;
+			TranspositionTable* table;
+			const std::atomic<bool>* stop;
+			Clock::time_point deadline;
+			bool hasDeadline;
+			uint64_t nodes;
+			bool aborted;
+			// Set when the network matches the board, the accumulator then follows board
+			const NnueNetwork* network;
+			NnueAccumulator accumulator;
+
+			Searcher(const Board& board, const SearchLimits& limits, TranspositionTable* table) : board(board), table(table), stop(limits.stop), hasDeadline(limits.timeBudget.count() > 0), nodes(0), aborted(false), network(nullptr) {
+				deadline = Clock::now() + limits.timeBudget;
+				if (limits.network != nullptr && limits.network->Matches(board)) {
+					network = limits.network;
+					network->Refresh(board, accumulator);
+				}
+			}
+
+			inline bool TimeUp() {
+				if (!aborted && (nodes % TimeCheckInterval) == 0) {
+					aborted = (hasDeadline && Clock::now() >= deadline) || (stop != nullptr && stop->load(std::memory_order_relaxed));
+				}
+				return aborted;
+			}
+
+			// Score of playing move for toMove, from toMove's point of view
+			int ScoreMove(uint8_t move, unsigned int depth, int alpha, int beta, unsigned int ply, TileState toMove) {
+				Coord c = UnpackMove(move);
+				board.Set(c, toMove);
+
+				int score;
+				switch (board.GetState()) {
+					case BoardState::CircleWin:
+					case BoardState::CrossWin:
+						score = WinScore - static_cast<int>(ply + 1);
+						break;
+					case BoardState::Tied:
+						score = 0;
+						break;
+					default:
+						if (network != nullptr) {
+							network->Add(accumulator, c.x, c.y, toMove);
+						}
+						score = -Negamax(depth - 1, -beta, -alpha, ply + 1, Opponent(toMove));
+						if (network != nullptr) {
+							network->Remove(accumulator, c.x, c.y, toMove);
+						}
+						break;
+				}
+
+				board.Unset(c);
+				return score;
+			}
+
+			int Negamax(unsigned int depth, int alpha, int beta, unsigned int ply, TileState toMove) {
+				nodes++;
+				if (TimeUp()) {
+					return 0;
+				}
+
+				if (depth == 0) {
+					return network != nullptr ? network->Evaluate(accumulator, toMove) : Evaluate(board, toMove);
+				}
+
+				uint64_t key = 0;
+				uint8_t hint = NoMove;
+				if (table != nullptr) {
+					key = board.Hash() ^ SideKey(toMove);
+					TableEntry entry;
+					if (table->Probe(key, entry)) {
+						int score = ScoreFromTable(entry.score, ply);
+						if (entry.depth >= depth) {
+							if (entry.bound == Bound::Exact) {
+								return score;
+							}
+							if (entry.bound == Bound::Lower && score > alpha) {
+								alpha = score;
+							} else if (entry.bound == Bound::Upper && score < beta) {
+								beta = score;
+							}
+							if (alpha >= beta) {
+								return score;
+							}
+						}
+						hint = entry.move;
+					}
+				}
+
+				uint8_t moves[MaxMoves];
+				unsigned int count = GenerateMoves(board, moves);
+				PromoteMove(moves, count, hint);
+
+				int originalAlpha = alpha;
+				int best = -WinScore;
+				uint8_t bestMove = NoMove;
+				for (unsigned int i = 0; i < count; i++) {
+					int score = ScoreMove(moves[i], depth, alpha, beta, ply, toMove);
+					if (aborted) {
+						return 0;
+					}
+
+					if (score > best) {
+						best = score;
+						bestMove = moves[i];
+					}
+					if (score > alpha) {
+						alpha = score;
+					}
+					if (alpha >= beta) {
+						break;
+					}
+				}
+
+				if (table != nullptr) {
+					Bound bound = best <= originalAlpha ? Bound::Upper : best >= beta ? Bound::Lower : Bound::Exact;
+					table->Store(key, ScoreToTable(best, ply), bestMove, bound, static_cast<uint16_t>(depth));
+				}
+
+				return best;
+			}
+		};
+	}
+
+	SearchLimits LimitsFor(Difficulty difficulty) {
+		switch (difficulty) {
+			case Difficulty::Easy:
+				return SearchLimits { 1, std::chrono::milliseconds(5), 0.3f };
+			case Difficulty::Medium:
+				return SearchLimits { 3, std::chrono::milliseconds(20), 0.1f };
+			case Difficulty::Hard:
+				return SearchLimits { 6, std::chrono::milliseconds(100), 0.02f };
+			case Difficulty::Perfect:
+				return SearchLimits { 0, std::chrono::milliseconds(500), 0.0f };
+		}
+		return SearchLimits { 0, std::chrono::milliseconds(0), 0.0f };
+	}
+
+	// Every window of k cells that only holds tiles of one side is a potential line, worth
+	// 8^(tiles - 1) to that side. The values come from the pattern tables. With long lines
+	// (k >= 7) a single window can outweigh WinThreshold, so the sum is clamped below it to
+	// stay a heuristic estimate.
+	int Evaluate(const Board& board, TileState side) {
+		int64_t score = 0;
+		ForEachWindow(board, [&score](unsigned int, unsigned int, const Pattern& pattern) {
+			score += pattern.score;
+		});
+
+		score = std::min<int64_t>(std::max<int64_t>(score, -(WinThreshold - 1)), WinThreshold - 1);
+		return static_cast<int>(side == TileState::Circle ? score : -score);
+	}
+
+	SearchResult Search(const Board& board, TileState side, const SearchLimits& limits, uint32_t seed, TranspositionTable* table) {
+		TRACE_ZONE("ttt::Search");
+
+		SearchResult result {};
+		result.valid = false;
+		if (board.GetState() != BoardState::Regular) {
+			return result;
+		}
+
+		Searcher searcher(board, limits, table);
+
+		uint8_t moves[MaxMoves];
+		unsigned int count = GenerateMoves(board, moves);
+		if (count == 0) {
+			return result;
+		}
+
+		result.valid = true;
+		result.move = UnpackMove(moves[0]);
+		result.score = 0;
+
+		if (limits.errorRate > 0.0f) {
+			std::minstd_rand rng(seed + 1);
+			std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+			if (chance(rng) < limits.errorRate) {
+				result.move = UnpackMove(moves[std::uniform_int_distribution<unsigned int>(0, count - 1)(rng)]);
+				result.random = true;
+				result.complete = true;
+				return result;
+			}
+		}
+
+		// Start from the best move of an earlier search of this position
+		if (table != nullptr) {
+			TableEntry entry;
+			if (table->Probe(board.Hash() ^ SideKey(side), entry)) {
+				PromoteMove(moves, count, entry.move);
+			}
+		}
+
+		unsigned int maxDepth = board.EmptyCount();
+		if (limits.maxDepth > 0 && limits.maxDepth < maxDepth) {
+			maxDepth = limits.maxDepth;
+		}
+
+		for (unsigned int depth = 1; depth <= maxDepth; depth++) {
+			int alpha = -WinScore;
+			int bestScore = -WinScore;
+			unsigned int bestIndex = 0;
+
+			for (unsigned int i = 0; i < count; i++) {
+				int score = searcher.ScoreMove(moves[i], depth, alpha, WinScore, 0, side);
+				if (searcher.aborted) {
+					break;
+				}
+
+				if (score > bestScore) {
+					bestScore = score;
+					bestIndex = i;
+				}
+				if (score > alpha) {
+					alpha = score;
+				}
+			}
+
+			if (searcher.aborted) {
+				break;
+			}
+
+			// Search the best move first in the next iteration
+			uint8_t best = moves[bestIndex];
+			for (unsigned int i = bestIndex; i > 0; i--) {
+				moves[i] = moves[i - 1];
+			}
+			moves[0] = best;
+
+			result.move = UnpackMove(best);
+			result.score = bestScore;
+			result.depth = depth;
+
+			// A forced result does not change with more depth
+			if (bestScore >= WinThreshold || bestScore <= -WinThreshold) {
+				break;
+			}
+		}
+
+		result.nodes = searcher.nodes;
+		result.complete = !searcher.aborted;
+		TRACE_COUNTER("ttt::Search nodes", result.nodes);
+		return result;
+	}
+}
\ No newline at end of file
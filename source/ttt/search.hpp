@@ -0,0 +1,64 @@
+#pragma once
+#include "board.hpp"
+#include "transposition.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ttt {
+	class NnueNetwork;
+
+	enum class Difficulty {
+		Easy,
+		Medium,
+		Hard,
+		Perfect
+	};
+
+	struct SearchLimits {
+		// Maximum search depth in plies, 0 searches until the board is full
+		unsigned int maxDepth;
+		// Wall-clock budget for the whole move, 0 disables the limit
+		std::chrono::microseconds timeBudget;
+		// Probability of playing a random legal move instead of searching
+		float errorRate;
+		// Aborts the search when set, like the time budget running out. Optional.
+		const std::atomic<bool>* stop = nullptr;
+		// Evaluates the horizon with this network instead of Evaluate() when it was trained for
+		// the board dimensions. Optional.
+		const NnueNetwork* network = nullptr;
+	};
+
+	SearchLimits LimitsFor(Difficulty difficulty);
+
+	// Scores are from the point of view of the side to move. Won/lost positions score
+	// +-(WinScore - plies to the end), anything below WinThreshold is a heuristic estimate.
+	constexpr int WinScore = 100000;
+	constexpr int WinThreshold = WinScore - 1000;
+
+	struct SearchResult {
+		Coord move;
+		int score;
+		// Depth of the last completed iteration, the move always comes from it
+		unsigned int depth;
+		uint64_t nodes;
+		// False when the board had no legal move
+		bool valid;
+		// True when the move was injected by the difficulty error rate
+		bool random;
+		// False when the time budget or the stop flag cut the search before it reached the
+		// depth limit or a forced result
+		bool complete;
+	};
+
+	// Iterative-deepening alpha-beta search. Every iteration is bounded by the time budget and
+	// an unfinished iteration is discarded, so the result is always the best move of the deepest
+	// completed iteration and the response time is bounded by the budget (plus at most one
+	// deadline check interval).
+	// An optional table is read and filled by the search, so searches sharing it (the same game
+	// over several moves, or a pondering thread) reuse each other's results.
+	SearchResult Search(const Board& board, TileState side, const SearchLimits& limits, uint32_t seed = 0, TranspositionTable* table = nullptr);
+
+	// Static evaluation of board for side, used at the search horizon
+	int Evaluate(const Board& board, TileState side);
+}
\ No newline at end of file
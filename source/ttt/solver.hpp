@@ -2,5 +2,6 @@
 #include "board.hpp"
 
 namespace ttt {
-    void NextMove(Board& board, int turn, bool solveForCircle = false);
+    // Fast rule-based move for the classic 3x3 game, see search.hpp for the real search
+    void NextMove(Board& board, bool solveForCircle = false);
 }
\ No newline at end of file
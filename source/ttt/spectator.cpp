@@ -0,0 +1,73 @@
+#include "spectator.hpp"
+#include "../core/trace.hpp"
+
+namespace ttt {
+	SpectatorWall::SpectatorWall(unsigned int count, Difficulty difficulty) : limits(LimitsFor(difficulty)), gamesFinished(0), movesPlayed(0) {
+		Resize(count);
+	}
+
+	void SpectatorWall::Restart(Game& game, unsigned int index) {
+		game.board.Reset();
+		// Alternate the first player so both sides get to open
+		game.toMove = (game.seed & 1) != 0 ? TileState::Cross : TileState::Circle;
+		game.holdSteps = 0;
+		game.seed = game.seed * 1664525u + 1013904223u + index;
+	}
+
+	void SpectatorWall::Resize(unsigned int count) {
+		unsigned int previous = Count();
+		games.resize(count);
+		for (unsigned int i = previous; i < count; i++) {
+			games[i].seed = i * 2654435761u;
+			Restart(games[i], i);
+			// Stagger new games so the wall does not move in lockstep
+			games[i].holdSteps = i % HoldSteps;
+		}
+	}
+
+	unsigned int SpectatorWall::Step(Game& game, unsigned int index, bool& finished) {
+		finished = false;
+		if (game.holdSteps > 0) {
+			if (--game.holdSteps == 0 && game.board.GetState() != BoardState::Regular) {
+				Restart(game, index);
+			}
+			return 0;
+		}
+
+		SearchResult result = Search(game.board, game.toMove, limits, game.seed);
+		game.seed = game.seed * 1664525u + 1013904223u;
+		unsigned int moves = 0;
+		if (result.valid) {
+			game.board.Set(result.move, game.toMove);
+			game.toMove = Opponent(game.toMove);
+			moves = 1;
+		}
+
+		if (game.board.GetState() != BoardState::Regular || !result.valid) {
+			finished = true;
+			game.holdSteps = HoldSteps;
+		}
+		return moves;
+	}
+
+	void SpectatorWall::Step(core::JobSystem* jobs) {
+		TRACE_ZONE("ttt::SpectatorWall::Step");
+		auto stepRange = [this](uint32_t begin, uint32_t end) {
+			uint64_t finished = 0;
+			uint64_t moves = 0;
+			for (uint32_t i = begin; i < end; i++) {
+				bool gameFinished;
+				moves += Step(games[i], i, gameFinished);
+				finished += gameFinished ? 1 : 0;
+			}
+			gamesFinished.fetch_add(finished, std::memory_order_relaxed);
+			movesPlayed.fetch_add(moves, std::memory_order_relaxed);
+		};
+
+		if (jobs != nullptr) {
+			jobs->ParallelFor(Count(), GamesPerJob, stepRange);
+		} else {
+			stepRange(0, Count());
+		}
+	}
+}
\ No newline at end of file
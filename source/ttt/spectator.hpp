@@ -0,0 +1,48 @@
+#pragma once
+#include "board.hpp"
+#include "search.hpp"
+#include "../core/job_system.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace ttt {
+	// Many concurrent AI-vs-AI games, stepped together, for the spectator wall
+	class SpectatorWall {
+	public:
+		// Steps a finished game stays on the wall before it restarts
+		static constexpr unsigned int HoldSteps = 30;
+		// Games stepped by one job
+		static constexpr unsigned int GamesPerJob = 8;
+	protected:
+		struct Game {
+			Board board;
+			TileState toMove;
+			unsigned int holdSteps;
+			uint32_t seed;
+		};
+
+		std::vector<Game> games;
+		SearchLimits limits;
+		std::atomic<uint64_t> gamesFinished;
+		std::atomic<uint64_t> movesPlayed;
+
+		void Restart(Game& game, unsigned int index);
+		// Returns the number of moves played (0 or 1), sets finished when the game ended
+		unsigned int Step(Game& game, unsigned int index, bool& finished);
+	public:
+		SpectatorWall(unsigned int count = 0, Difficulty difficulty = Difficulty::Easy);
+
+		// Adds or removes games, kept games continue where they were
+		void Resize(unsigned int count);
+		// Plays one move in every running game. Games are independent, with a job system they
+		// are stepped in parallel.
+		void Step(core::JobSystem* jobs = nullptr);
+
+		inline unsigned int Count() const { return static_cast<unsigned int>(games.size()); }
+		inline const Board& Get(unsigned int index) const { return games[index].board; }
+
+		inline uint64_t GamesFinished() const { return gamesFinished.load(std::memory_order_relaxed); }
+		inline uint64_t MovesPlayed() const { return movesPlayed.load(std::memory_order_relaxed); }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "transposition.hpp"
+#include "search.hpp"
+
+namespace ttt {
+	int ScoreToTable(int score, unsigned int ply) {
+		if (score >= WinThreshold) {
+			return score + static_cast<int>(ply);
+		}
+		if (score <= -WinThreshold) {
+			return score - static_cast<int>(ply);
+		}
+		return score;
+	}
+
+	int ScoreFromTable(int score, unsigned int ply) {
+		if (score >= WinThreshold) {
+			return score - static_cast<int>(ply);
+		}
+		if (score <= -WinThreshold) {
+			return score + static_cast<int>(ply);
+		}
+		return score;
+	}
+
+	namespace {
+		inline uint64_t Pack(int score, uint8_t move, Bound bound, uint16_t depth) {
+			return static_cast<uint64_t>(static_cast<uint32_t>(score)) | (static_cast<uint64_t>(move) << 32) |
+				(static_cast<uint64_t>(bound) << 40) | (static_cast<uint64_t>(depth) << 48);
+		}
+	}
+
+	TranspositionTable::TranspositionTable(size_t entryCount) {
+		size_t size = 1;
+		while (size * 2 <= entryCount) {
+			size *= 2;
+		}
+
+		slots.reset(new Slot[size]);
+		mask = size - 1;
+		Clear();
+	}
+
+	bool TranspositionTable::Probe(uint64_t key, TableEntry& entry) const {
+		const Slot& slot = slots[key & mask];
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		uint64_t check = slot.check.load(std::memory_order_relaxed);
+		Bound bound = static_cast<Bound>((data >> 40) & 0xFF);
+		if (bound == Bound::None || (check ^ data) != key) {
+			return false;
+		}
+
+		entry.key = key;
+		entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+		entry.move = static_cast<uint8_t>(data >> 32);
+		entry.bound = bound;
+		entry.depth = static_cast<uint16_t>(data >> 48);
+		return true;
+	}
+
+	void TranspositionTable::Store(uint64_t key, int score, uint8_t move, Bound bound, uint16_t depth) {
+		Slot& slot = slots[key & mask];
+		uint64_t data = Pack(score, move, bound, depth);
+		slot.data.store(data, std::memory_order_relaxed);
+		slot.check.store(key ^ data, std::memory_order_relaxed);
+	}
+
+	void TranspositionTable::Clear() {
+		for (size_t i = 0; i <= mask; i++) {
+			slots[i].data.store(0, std::memory_order_relaxed);
+			slots[i].check.store(0, std::memory_order_relaxed);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include "board.hpp"
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ttt {
+	enum class Bound : uint8_t {
+		None,
+		Exact,
+		// The real score is at least the stored one (fail high)
+		Lower,
+		// The real score is at most the stored one (fail low)
+		Upper
+	};
+
+	constexpr uint8_t NoMove = 0xFF;
+
+	struct TableEntry {
+		uint64_t key;
+		int32_t score;
+		uint8_t move;
+		Bound bound;
+		// Remaining search depth the score was computed with, 0xFFFF for a full solve
+		uint16_t depth;
+	};
+
+	// Key of the side to move, xor it into Board::Hash() to key positions
+	inline uint64_t SideKey(TileState side) {
+		return side == TileState::Cross ? MixKey(0xC0550000) : 0;
+	}
+
+	// Won/lost scores depend on the distance from the search root, the table stores them
+	// relative to the node instead so an entry stays valid when reached from another root
+	int ScoreToTable(int score, unsigned int ply);
+	int ScoreFromTable(int score, unsigned int ply);
+
+	// Fixed-size, always-replace hash table of search results keyed by position.
+	// It can be shared by concurrent searches without locks: an entry is packed into one 64-bit
+	// word, stored next to key ^ word. A slot torn by two concurrent stores fails the key check
+	// on Probe and reads as a miss instead of returning a mix of both entries.
+	class TranspositionTable {
+	protected:
+		struct Slot {
+			std::atomic<uint64_t> check;
+			std::atomic<uint64_t> data;
+		};
+
+		std::unique_ptr<Slot[]> slots;
+		size_t mask;
+	public:
+		// entryCount is rounded down to a power of two
+		explicit TranspositionTable(size_t entryCount);
+		TranspositionTable(const TranspositionTable&) = delete;
+		TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+		bool Probe(uint64_t key, TableEntry& entry) const;
+		void Store(uint64_t key, int score, uint8_t move, Bound bound, uint16_t depth);
+		// Not safe while another thread uses the table
+		void Clear();
+
+		inline size_t Size() const { return mask + 1; }
+	};
+}
\ No newline at end of file
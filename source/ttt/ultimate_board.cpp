@@ -0,0 +1,150 @@
+#include "ultimate_board.hpp"
+
+namespace ttt {
+	namespace {
+		constexpr uint16_t FullMask = 0x1FF;
+
+		const uint16_t lineMasks[8] = {
+			0x007, 0x038, 0x1C0,	// Rows
+			0x049, 0x092, 0x124,	// Columns
+			0x111, 0x054			// Diagonals
+		};
+
+		inline bool HasLine(uint16_t mask) {
+			for (uint16_t line : lineMasks) {
+				if ((mask & line) == line) {
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+
+	void UltimateState::Reset() {
+		for (auto& side : cells) {
+			for (auto& board : side) {
+				board = 0;
+			}
+		}
+		won[0] = 0;
+		won[1] = 0;
+		decided = 0;
+		active = -1;
+		toMove = 0;
+		result = BoardState::Regular;
+	}
+
+	unsigned int UltimateState::GenerateMoves(UltimateMove* moves) const {
+		if (result != BoardState::Regular) {
+			return 0;
+		}
+
+		unsigned int count = 0;
+		unsigned int first = active >= 0 ? active : 0;
+		unsigned int last = active >= 0 ? active : 8;
+		for (unsigned int b = first; b <= last; b++) {
+			if (decided & (1 << b)) {
+				continue;
+			}
+
+			uint16_t empty = ~(cells[0][b] | cells[1][b]) & FullMask;
+			while (empty != 0) {
+				unsigned int cell = __builtin_ctz(empty);
+				empty &= empty - 1;
+				moves[count++] = MakeUltimateMove(b, cell);
+			}
+		}
+
+		return count;
+	}
+
+	bool UltimateState::IsLegal(UltimateMove move) const {
+		if (result != BoardState::Regular || move >= UltimateMaxMoves) {
+			return false;
+		}
+
+		unsigned int b = move / 9;
+		unsigned int cell = move % 9;
+		if (active >= 0 && static_cast<unsigned int>(active) != b) {
+			return false;
+		}
+
+		if (decided & (1 << b)) {
+			return false;
+		}
+
+		return ((cells[0][b] | cells[1][b]) & (1 << cell)) == 0;
+	}
+
+	void UltimateState::Apply(UltimateMove move) {
+		unsigned int b = move / 9;
+		unsigned int cell = move % 9;
+
+		uint16_t& mine = cells[toMove][b];
+		mine |= 1 << cell;
+
+		if (HasLine(mine)) {
+			won[toMove] |= 1 << b;
+			decided |= 1 << b;
+			if (HasLine(won[toMove])) {
+				result = toMove == 0 ? BoardState::CircleWin : BoardState::CrossWin;
+			}
+		} else if ((cells[0][b] | cells[1][b]) == FullMask) {
+			decided |= 1 << b;
+		}
+
+		if (result == BoardState::Regular && decided == FullMask) {
+			result = BoardState::Tied;
+		}
+
+		active = (decided & (1 << cell)) ? -1 : static_cast<int8_t>(cell);
+		toMove ^= 1;
+	}
+
+	UltimateBoard::UltimateBoard() {
+		packed.Reset();
+	}
+
+	void UltimateBoard::Reset() {
+		for (auto& row : boards) {
+			for (auto& board : row) {
+				board.Reset();
+			}
+		}
+		meta.Reset();
+		packed.Reset();
+	}
+
+	const Board& UltimateBoard::Get(unsigned int x, unsigned int y) const {
+		if (x >= 3 || y >= 3) {
+			return boards[0][0];
+		}
+
+		return boards[y][x];
+	}
+
+	bool UltimateBoard::IsLegal(UltimateMove move) const {
+		return packed.IsLegal(move);
+	}
+
+	bool UltimateBoard::Play(UltimateMove move) {
+		if (!packed.IsLegal(move)) {
+			return false;
+		}
+
+		unsigned int b = move / 9;
+		unsigned int cell = move % 9;
+		TileState side = packed.ToMove();
+
+		Board& board = boards[b / 3][b % 3];
+		board.Set(cell % 3, cell / 3, side);
+
+		BoardState boardState = board.GetState();
+		if (boardState == BoardState::CircleWin || boardState == BoardState::CrossWin) {
+			meta.Set(b % 3, b / 3, side);
+		}
+
+		packed.Apply(move);
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include "board.hpp"
+#include <cstdint>
+
+namespace ttt {
+	// A move of the ultimate variant, packed as subBoard * 9 + cell. Both sub-boards and cells
+	// are numbered y * 3 + x.
+	typedef uint8_t UltimateMove;
+
+	constexpr unsigned int UltimateMaxMoves = 81;
+
+	inline UltimateMove MakeUltimateMove(unsigned int subBoard, unsigned int cell) {
+		return static_cast<UltimateMove>(subBoard * 9 + cell);
+	}
+
+	// Packed search state of the ultimate variant: 81 cells as one 9-bit mask per side and
+	// sub-board, plus the meta-board. 48 bytes, trivially copyable, no pointers.
+	struct UltimateState {
+		uint16_t cells[2][9];	// [side][subBoard], side 0 = circle, 1 = cross
+		uint16_t won[2];		// Sub-boards won by each side
+		uint16_t decided;		// Sub-boards that are won or full, no longer playable
+		int8_t active;			// Sub-board the side to move must play in, -1 when free
+		uint8_t toMove;			// 0 = circle, 1 = cross
+		BoardState result;
+
+		void Reset();
+
+		// Legal moves in ascending order, returns their count (at most UltimateMaxMoves)
+		unsigned int GenerateMoves(UltimateMove* moves) const;
+		bool IsLegal(UltimateMove move) const;
+		// Plays move for the side to move, the move must be legal
+		void Apply(UltimateMove move);
+
+		inline TileState ToMove() const { return toMove == 0 ? TileState::Circle : TileState::Cross; }
+	};
+
+	// Nine-board "ultimate" tic-tac-toe: every cell of the outer grid is a ttt::Board, and the
+	// cell a move is played in decides which sub-board the opponent must play in next. A won
+	// sub-board is claimed on the meta-board, three claimed sub-boards in a row win the game.
+	class UltimateBoard {
+	protected:
+		Board boards[3][3];
+		Board meta;
+		UltimateState packed;
+	public:
+		UltimateBoard();
+		void Reset();
+
+		const Board& Get(unsigned int x, unsigned int y) const;
+		inline const Board& Meta() const { return meta; }
+
+		// Sub-board (y * 3 + x) the next move must be played in, -1 when any is allowed
+		inline int ActiveBoard() const { return packed.active; }
+		inline TileState ToMove() const { return packed.ToMove(); }
+		inline BoardState GetState() const { return packed.result; }
+
+		bool IsLegal(UltimateMove move) const;
+		// Plays move for the side to move, returns false if it is not legal
+		bool Play(UltimateMove move);
+
+		inline const UltimateState& Pack() const { return packed; }
+	};
+}
\ No newline at end of file
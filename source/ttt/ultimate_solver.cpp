@@ -0,0 +1,170 @@
+#include "ultimate_solver.hpp"
+#include "../core/trace.hpp"
+#include <cmath>
+
+namespace ttt {
+	namespace {
+		typedef std::chrono::steady_clock Clock;
+
+		// How often (in playouts) the deadline is checked
+		constexpr uint32_t TimeCheckInterval = 64;
+
+		// UCT exploration constant
+		constexpr float Exploration = 1.41421356f;
+
+		inline float Reward(BoardState result, uint8_t mover) {
+			switch (result) {
+				case BoardState::CircleWin:
+					return mover == 0 ? 1.0f : 0.0f;
+				case BoardState::CrossWin:
+					return mover == 1 ? 1.0f : 0.0f;
+				default:
+					return 0.5f;
+			}
+		}
+	}
+
+	UltimateSolver::UltimateSolver(uint32_t nodeCapacity, uint64_t seed) : nodes(new Node[nodeCapacity < 2 ? 2 : nodeCapacity]), capacity(nodeCapacity < 2 ? 2 : nodeCapacity), used(0), rng(seed != 0 ? seed : 1) {
+
+	}
+
+	uint32_t UltimateSolver::Allocate(uint32_t count) {
+		if (used + count > capacity) {
+			return 0;
+		}
+
+		uint32_t first = used;
+		used += count;
+		return first;
+	}
+
+	uint32_t UltimateSolver::NextRandom() {
+		// xorshift64*
+		rng ^= rng >> 12;
+		rng ^= rng << 25;
+		rng ^= rng >> 27;
+		return static_cast<uint32_t>((rng * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+
+	uint32_t UltimateSolver::Select(const Node& parent) const {
+		float logVisits = std::log(static_cast<float>(parent.visits));
+		uint32_t best = parent.firstChild;
+		float bestValue = -1.0f;
+
+		for (uint32_t i = parent.firstChild; i < parent.firstChild + parent.childCount; i++) {
+			const Node& child = nodes[i];
+			if (child.visits == 0) {
+				return i;
+			}
+
+			float value = child.score / child.visits + Exploration * std::sqrt(logVisits / child.visits);
+			if (value > bestValue) {
+				bestValue = value;
+				best = i;
+			}
+		}
+
+		return best;
+	}
+
+	BoardState UltimateSolver::Playout(UltimateState& state) {
+		UltimateMove moves[UltimateMaxMoves];
+		while (state.result == BoardState::Regular) {
+			unsigned int count = state.GenerateMoves(moves);
+			state.Apply(moves[NextRandom() % count]);
+		}
+
+		return state.result;
+	}
+
+	UltimateSearchResult UltimateSolver::Search(const UltimateState& state, const UltimateSearchLimits& limits) {
+		TRACE_ZONE("ttt::UltimateSolver::Search");
+
+		UltimateSearchResult result {};
+		if (state.result != BoardState::Regular) {
+			return result;
+		}
+
+		used = 1;
+		nodes[0] = Node { 0, 0, 0.0f, 0, 0 };
+
+		bool hasDeadline = limits.timeBudget.count() > 0;
+		Clock::time_point deadline = Clock::now() + limits.timeBudget;
+		uint32_t maxIterations = limits.maxIterations;
+		if (maxIterations == 0 && !hasDeadline) {
+			maxIterations = UltimateSearchLimits::DefaultMaxIterations;
+		}
+
+		UltimateMove moves[UltimateMaxMoves];
+		uint32_t path[UltimateMaxMoves + 1];
+
+		uint32_t iteration = 0;
+		for (;; iteration++) {
+			if (maxIterations > 0 && iteration >= maxIterations) {
+				break;
+			}
+			if (hasDeadline && (iteration % TimeCheckInterval) == 0 && iteration > 0 && Clock::now() >= deadline) {
+				break;
+			}
+
+			UltimateState current = state;
+			uint32_t depth = 0;
+			uint32_t node = 0;
+			path[depth++] = node;
+
+			// Selection
+			while (nodes[node].childCount > 0 && current.result == BoardState::Regular) {
+				node = Select(nodes[node]);
+				current.Apply(nodes[node].move);
+				path[depth++] = node;
+			}
+
+			// Expansion, a leaf is expanded on its second visit (the root right away)
+			if (current.result == BoardState::Regular && (nodes[node].visits > 0 || node == 0)) {
+				unsigned int count = current.GenerateMoves(moves);
+				uint32_t first = Allocate(count);
+				if (first != 0) {
+					for (unsigned int i = 0; i < count; i++) {
+						nodes[first + i] = Node { 0, 0, 0.0f, moves[i], 0 };
+					}
+					nodes[node].firstChild = first;
+					nodes[node].childCount = static_cast<uint8_t>(count);
+
+					node = first + NextRandom() % count;
+					current.Apply(nodes[node].move);
+					path[depth++] = node;
+				}
+			}
+
+			// Simulation
+			BoardState outcome = Playout(current);
+
+			// Backpropagation, path[i] was entered by a move of (state.toMove + i - 1)
+			for (uint32_t i = 0; i < depth; i++) {
+				Node& n = nodes[path[i]];
+				uint8_t mover = (state.toMove + i + 1) & 1;
+				n.visits++;
+				n.score += Reward(outcome, mover);
+			}
+		}
+
+		const Node& root = nodes[0];
+		if (root.childCount == 0) {
+			return result;
+		}
+
+		const Node* best = &nodes[root.firstChild];
+		for (uint32_t i = root.firstChild; i < root.firstChild + root.childCount; i++) {
+			if (nodes[i].visits > best->visits) {
+				best = &nodes[i];
+			}
+		}
+
+		result.move = best->move;
+		result.iterations = iteration;
+		result.nodes = used;
+		result.expectedScore = best->visits > 0 ? best->score / best->visits : 0.5f;
+		result.valid = true;
+		return result;
+	}
+}
\ No newline at end of file
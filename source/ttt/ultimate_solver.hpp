@@ -0,0 +1,58 @@
+#pragma once
+#include "ultimate_board.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace ttt {
+	struct UltimateSearchLimits {
+		// Wall-clock budget for the move, 0 disables the limit
+		std::chrono::microseconds timeBudget;
+		// Maximum number of playouts, 0 disables the limit. When both limits are disabled the
+		// search stops after DefaultMaxIterations playouts.
+		uint32_t maxIterations;
+
+		static constexpr uint32_t DefaultMaxIterations = 100000;
+	};
+
+	struct UltimateSearchResult {
+		UltimateMove move;
+		uint32_t iterations;
+		uint32_t nodes;
+		// Expected score of move for the side to move, 1 = win, 0.5 = draw, 0 = loss
+		float expectedScore;
+		bool valid;
+	};
+
+	// Monte Carlo tree search engine for the ultimate variant.
+	// Tree nodes live in a fixed-capacity pool owned by the solver: a node's children are
+	// allocated contiguously in one bump allocation and the pool is rewound before every
+	// search, so searching never touches the heap. When the pool is full the tree stops
+	// growing and the remaining time is spent on deeper playouts from the existing leaves.
+	class UltimateSolver {
+	protected:
+		struct Node {
+			uint32_t firstChild;	// 0 while unexpanded, the root is never a child
+			uint32_t visits;
+			float score;			// Sum of playout results for the side that moved into the node
+			UltimateMove move;
+			uint8_t childCount;
+		};
+
+		std::unique_ptr<Node[]> nodes;
+		uint32_t capacity;
+		uint32_t used;
+		uint64_t rng;
+
+		uint32_t Allocate(uint32_t count);
+		uint32_t Select(const Node& parent) const;
+		uint32_t NextRandom();
+		BoardState Playout(UltimateState& state);
+	public:
+		UltimateSolver(uint32_t nodeCapacity = 1 << 18, uint64_t seed = 0x9E3779B97F4A7C15ull);
+		UltimateSolver(const UltimateSolver&) = delete;
+		UltimateSolver& operator=(const UltimateSolver&) = delete;
+
+		UltimateSearchResult Search(const UltimateState& state, const UltimateSearchLimits& limits);
+	};
+}
\ No newline at end of file